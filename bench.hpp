@@ -0,0 +1,66 @@
+// Tiny benchmark harness shared by bench_engine.cpp and bench_draw.cpp.
+// Every case repeats its body in growing batches until it has run for at
+// least --min-ms, then prints one CSV line:
+//   suite,benchmark,param,iterations,ns_per_op,ops_per_sec
+// Inputs come from fixed seeds, so numbers are comparable across commits.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class Bench {
+public:
+    explicit Bench(const char *suite) : suite(suite) {}
+
+    // Accepts --min-ms N and --filter SUBSTRING; returns false on bad usage
+    bool parseArgs(int argc, char **argv) {
+        for (int i = 1; i < argc; ++i) {
+            if (!std::strcmp(argv[i], "--min-ms") && i + 1 < argc) minSeconds = std::atof(argv[++i]) / 1000.0;
+            else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+            else if (!std::strcmp(argv[i], "--no-header")) header = false;
+            else {
+                std::fprintf(stderr, "usage: %s [--min-ms N] [--filter SUBSTRING] [--no-header]\n", argv[0]);
+                return false;
+            }
+        }
+        if (header) std::printf("suite,benchmark,param,iterations,ns_per_op,ops_per_sec\n");
+        return true;
+    }
+
+    // Times `op`, which is called once per iteration and returns a value
+    // that is folded into a sink so the work cannot be optimised away
+    template <typename Op>
+    void run(const char *name, const std::string &param, Op &&op) {
+        if (!filter.empty() && (std::string(name) + "/" + param).find(filter) == std::string::npos) return;
+        std::uint64_t iterations = 0;
+        double elapsed = 0;
+        for (std::uint64_t batch = 1; elapsed < minSeconds; batch *= 2) {
+            std::uint64_t acc = 0;
+            const auto start = Clock::now();
+            for (std::uint64_t i = 0; i < batch; ++i) acc += static_cast<std::uint64_t>(op());
+            sink = sink + acc;
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+            iterations += batch;
+        }
+        const double ns = elapsed * 1e9 / static_cast<double>(iterations);
+        std::printf("%s,%s,%s,%llu,%.2f,%.0f\n", suite, name, param.c_str(),
+                    static_cast<unsigned long long>(iterations), ns, 1e9 / ns);
+        std::fflush(stdout);
+    }
+
+    // Checksum of everything the benchmarks returned
+    std::uint64_t checksum() const { return sink; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const char *suite;
+    double minSeconds = 0.2;
+    std::string filter;
+    bool header = true;
+    volatile std::uint64_t sink = 0;
+};
@@ -0,0 +1,87 @@
+// Microbenchmarks for the draw paths of both games, rendered into an
+// offscreen RenderTexture. Each iteration clears the texture, draws and calls
+// display(), so it measures CPU-side submission plus the GL flush. Needs an
+// OpenGL context; without one the suite reports that and draws nothing.
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "bench.hpp"
+#include "tetris_render.hpp"
+#include "embedded_font.hpp"
+
+static constexpr unsigned SEED = 12345;
+
+static void benchTetrisDraw(Bench &bench, const sf::Font &font) {
+    sf::RenderTexture target;
+    if (!target.create(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        std::fprintf(stderr, "bench_draw: cannot create a render texture, skipping tetris\n");
+        return;
+    }
+    BoardRenderer board;
+    SidePanel panel;
+    panel.init(font);
+
+    // A game that keeps changing: random inputs, restarted when it ends
+    TetrisEngine engine(SEED);
+    std::uint32_t rng = SEED;
+    auto play = [&] {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        if (engine.isGameOver()) engine.reset();
+        engine.step(static_cast<Action>(rng % static_cast<unsigned>(Action::Count)));
+    };
+
+    bench.run("tetrisBoard", "static", [&] {
+        target.clear();
+        const int changed = board.update(engine, engine.getCurrent(), 0.f);
+        board.draw(target);
+        target.display();
+        return changed;
+    });
+    bench.run("tetrisBoard", "playing", [&] {
+        play();
+        target.clear();
+        const int changed = board.update(engine, engine.getCurrent(), 0.5f);
+        board.draw(target);
+        target.display();
+        return changed;
+    });
+    int score = 0;
+    bench.run("tetrisSidePanel", "score-changing", [&] {
+        ++score;
+        target.clear();
+        panel.update(score, score / 1000, score / 100);
+        const int draws = panel.draw(target);
+        target.display();
+        return draws;
+    });
+    bench.run("tetrisFrame", "playing", [&] {
+        play();
+        target.clear();
+        board.update(engine, engine.getCurrent(), 0.5f);
+        int draws = board.draw(target);
+        panel.update(engine.getScore(), engine.getLevel(), engine.getLinesCleared());
+        panel.updatePreview(engine);
+        draws += panel.draw(target);
+        target.display();
+        return draws;
+    });
+}
+
+// In bench_draw_snake.cpp: the snake's layout constants share names with
+// the Tetris ones, so each game's draw cases get a translation unit of their own
+void benchSnakeDraw(Bench &bench, const sf::Font &font);
+void benchSnakeWorldDraw(Bench &bench, const sf::Font &font);
+
+int main(int argc, char **argv) {
+    Bench bench("draw");
+    if (!bench.parseArgs(argc, argv)) return 1;
+    sf::Font font;
+    loadEmbeddedFont(font);
+    benchTetrisDraw(bench, font);
+    benchSnakeDraw(bench, font);
+    benchSnakeWorldDraw(bench, font);
+    return 0;
+}
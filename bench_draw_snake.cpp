@@ -0,0 +1,71 @@
+// Snake draw cases for bench_draw; see bench_draw.cpp
+#include <SFML/Graphics.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "snake_render.hpp"
+#include "snake_world_render.hpp"
+
+using std::vector;
+
+void benchSnakeDraw(Bench &bench, const sf::Font &font) {
+    sf::RenderTexture target;
+    if (!target.create(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        std::fprintf(stderr, "bench_draw: cannot create a render texture, skipping snake\n");
+        return;
+    }
+    SnakeRenderer renderer(font);
+
+    for (int length : {3, 32, 128, 360}) {
+        // Serpentine body filling rows from the top
+        vector<Position> body;
+        for (int i = 0; i < length; ++i) {
+            const int row = i / GRID_WIDTH;
+            const int col = i % GRID_WIDTH;
+            body.insert(body.begin(), Position(row % 2 ? GRID_WIDTH - 1 - col : col, row));
+        }
+        SnakeEngine game;
+        game.setSnake(body, RIGHT);
+        game.setFood(Position(0, GRID_HEIGHT - 1));
+        renderer.invalidate();
+        bench.run("snakeDraw", "length=" + std::to_string(length), [&] {
+            target.clear();
+            const int draws = renderer.draw(target, game, 0.5f);
+            target.display();
+            return draws;
+        });
+    }
+}
+
+// World mode: the snake follows a cycle through a large grid, moving once
+// per frame, so chunks are rebuilt and the camera scrolls as in play
+void benchSnakeWorldDraw(Bench &bench, const sf::Font &font) {
+    sf::RenderTexture target;
+    if (!target.create(WORLD_VIEW_WIDTH, WORLD_WINDOW_HEIGHT)) {
+        std::fprintf(stderr, "bench_draw: cannot create a render texture, skipping snake world\n");
+        return;
+    }
+    const int size = 2000;
+    const vector<Position> cycle = hamiltonianCycle(size, size - 1);
+    const int cells = static_cast<int>(cycle.size());
+    for (int length : {100, 10000, 1000000}) {
+        SnakeEngine game(size, size);
+        vector<Position> body;
+        for (int i = 0; i < length; ++i) body.push_back(cycle[length - 1 - i]);
+        game.setSnake(body, towards(body[1], body[0]));
+        game.setFood(Position(0, size - 1));
+        SnakeWorldRenderer renderer(font);
+        int head = length - 1;
+        bench.run("snakeWorldDraw", "grid=2000x2000 length=" + std::to_string(length), [&] {
+            head = (head + 1) % cells;
+            game.steer(towards(game.getBody()[0], cycle[head]));
+            game.moveSnake();
+            renderer.noteMove(game);
+            target.clear();
+            const int draws = renderer.draw(target, game, 0.5f);
+            target.display();
+            return draws;
+        });
+    }
+}
@@ -0,0 +1,310 @@
+// Microbenchmarks for the game logic hot paths: Tetris collision, line
+// clears, ghost and hard drop on the standard and a 64x1000 board, and the
+// snake's move, collision test, food placement and autopilot decision at
+// several lengths, and forking and snapshotting both games. Needs no SFML;
+// see bench.hpp for the output. First checks the SSE2 full-row search
+// against a plain loop and exits non-zero if they disagree.
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "tetris_engine.hpp"
+#include "snake_engine.hpp"
+#include "snake_ai.hpp"
+
+using std::size_t;
+using std::vector;
+
+static constexpr unsigned SEED = 12345;
+
+// xorshift32, so every input set is the same on every machine
+static std::uint32_t nextRandom(std::uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// A board whose bottom `fullRows` rows are full and whose next `ragged` rows
+// are partly filled, never completely
+static Board makeBoard(int fullRows, int ragged, std::uint32_t seed) {
+    Board board{};
+    for (int r = ROWS - fullRows; r < ROWS; ++r) board[r] = FULL_ROW;
+    for (int r = ROWS - fullRows - ragged; r < ROWS - fullRows; ++r) {
+        RowMask row = static_cast<RowMask>(nextRandom(seed) & FULL_ROW);
+        if (row == FULL_ROW) row &= static_cast<RowMask>(~(1u << (seed % COLS)));
+        board[r] = row;
+    }
+    return board;
+}
+
+static BoardColors colorsFor(const Board &board) {
+    BoardColors colors;
+    for (int r = 0; r < ROWS; ++r) {
+        for (int c = 0; c < COLS; ++c) colors[r][c] = (board[r] >> c & 1) ? static_cast<std::int8_t>(c % 7) : -1;
+    }
+    return colors;
+}
+
+static void benchTetris(Bench &bench) {
+    const Board empty{};
+    const Board mid = makeBoard(0, 10, SEED);
+
+    // Random placements, in bounds or not, for the collision test
+    vector<Piece> pieces(1024);
+    std::uint32_t rng = SEED;
+    for (auto &p : pieces) {
+        p.kind = static_cast<int>(nextRandom(rng) % 7);
+        p.rotation = static_cast<int>(nextRandom(rng) % 4);
+        p.x = static_cast<int>(nextRandom(rng) % (COLS + 2)) - 2;
+        p.y = static_cast<int>(nextRandom(rng) % ROWS) - 1;
+    }
+    for (const auto &named : {std::make_pair("empty", &empty), std::make_pair("mid", &mid)}) {
+        size_t i = 0;
+        bench.run("canPlace", std::string("board=") + named.first, [&] {
+            return rules::canPlace(named.second->data(), pieces[i++ & 1023]);
+        });
+    }
+
+    for (int full = 0; full <= 4; ++full) {
+        const Board source = makeBoard(full, 8, SEED + full);
+        const BoardColors sourceColors = colorsFor(source);
+        Board board;
+        BoardColors colors;
+        bench.run("clearLines", "full=" + std::to_string(full), [&] {
+            board = source;
+            colors = sourceColors;
+            return rules::clearFullRows(board.data(), &colors);
+        });
+    }
+
+    // The ghost is the active piece dropped as far as it goes, found from the
+    // column heights; dropDistanceScan is the row-by-row fallback
+    for (const auto &named : {std::make_pair("empty", &empty), std::make_pair("mid", &mid)}) {
+        ColumnHeights heights;
+        rules::computeHeights(named.second->data(), heights);
+        int kind = 0;
+        bench.run("updateGhost", std::string("board=") + named.first, [&] {
+            kind = kind == 6 ? 0 : kind + 1;
+            return rules::dropDistance(named.second->data(), heights, rules::spawnPiece(kind));
+        });
+        bench.run("dropDistanceScan", std::string("board=") + named.first, [&] {
+            kind = kind == 6 ? 0 : kind + 1;
+            return rules::dropDistance(named.second->data(), rules::spawnPiece(kind));
+        });
+    }
+
+    // Includes locking the piece, clearing lines and spawning the next one;
+    // the board is restored every time so the stack never grows
+    for (const auto &named : {std::make_pair("empty", &empty), std::make_pair("mid", &mid)}) {
+        const BoardColors sourceColors = colorsFor(*named.second);
+        ColumnHeights sourceHeights;
+        rules::computeHeights(named.second->data(), sourceHeights);
+        Board board;
+        BoardColors colors;
+        ColumnHeights heights;
+        RandomBag7 bag(SEED);
+        PlayState state;
+        int kind = 0;
+        bench.run("hardDrop", std::string("board=") + named.first, [&] {
+            board = *named.second;
+            colors = sourceColors;
+            heights = sourceHeights;
+            state = PlayState{};
+            kind = kind == 6 ? 0 : kind + 1;
+            state.current = rules::spawnPiece(kind);
+            rules::hardDrop(board.data(), &colors, &heights, bag, state);
+            return state.score;
+        });
+    }
+
+    // Piece randomizer, including a bag shuffle every seventh call
+    RandomBag7 bag(SEED);
+    bench.run("bagNext", "", [&] { return bag.next() + bag.peek(RandomBag7::LOOKAHEAD - 1); });
+}
+
+// Every range of a tall board with full rows scattered through it, so scans
+// run long enough to take the SIMD path of findLastFullRow, at each row width
+template <int W, int H>
+static bool checkFullRowSearch() {
+    using Mask = BasicRowMask<W>;
+    constexpr Mask full = fullRow<W>();
+    BasicBoard<W, H> board{};
+    std::uint32_t rng = SEED;
+    for (Mask &row : board) {
+        // One row in eight full, the rest one cell short
+        row = nextRandom(rng) % 8 == 0 ? full : static_cast<Mask>(full & ~(Mask{1} << (nextRandom(rng) % W)));
+    }
+    for (int first = 0; first < H; ++first) {
+        for (int end = first; end <= H; ++end) {
+            int expected = end - 1;
+            while (expected >= first && board[expected] != full) --expected;
+            if (expected < first) expected = -1;
+            if (rules::findLastFullRow<W, H>(board.data(), first, end) != expected) {
+                std::fprintf(stderr, "findLastFullRow<%d, %d>(%d, %d) is wrong\n", W, H, first, end);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Line clears and hard drops on a 64-column, 1000-row board. `full` rows
+// are spread through the stack; clearing them walks the whole board.
+static void benchWideTetris(Bench &bench) {
+    constexpr int W = 64, H = 1000;
+    using Mask = BasicRowMask<W>;
+    constexpr Mask full = fullRow<W>();
+    const std::string size = "board=64x1000";
+
+    // The bottom half is a stack with a gap in every row
+    auto makeStack = [&](int fullRows, std::uint32_t seed) {
+        auto board = std::make_unique<BasicBoard<W, H>>();
+        board->fill(0);
+        for (int r = H / 2; r < H; ++r) {
+            (*board)[r] = static_cast<Mask>(full & ~(Mask{1} << (nextRandom(seed) % W)));
+        }
+        for (int i = 0; i < fullRows; ++i) (*board)[H / 2 + i * (H / 2) / std::max(1, fullRows)] = full;
+        return board;
+    };
+
+    for (int fullRows : {0, 1, 4}) {
+        const auto source = makeStack(fullRows, SEED + fullRows);
+        auto board = std::make_unique<BasicBoard<W, H>>();
+        bench.run("clearLines", size + " full=" + std::to_string(fullRows), [&] {
+            *board = *source;
+            return rules::clearFullRows<W, H>(board->data(), nullptr);
+        });
+    }
+
+    const auto source = makeStack(0, SEED);
+    auto board = std::make_unique<BasicBoard<W, H>>();
+    BasicColumnHeights<W, H> sourceHeights, heights;
+    rules::computeHeights<W, H>(source->data(), sourceHeights);
+    RandomBag7 bag(SEED);
+    PlayState state;
+    int kind = 0;
+    bench.run("hardDrop", size, [&] {
+        std::copy(source->begin() + H / 2 - 8, source->begin() + H / 2 + 8, board->begin() + H / 2 - 8);
+        heights = sourceHeights;
+        state = PlayState{};
+        kind = kind == 6 ? 0 : kind + 1;
+        state.current = rules::spawnPiece<W, H>(kind);
+        rules::hardDrop<W, H>(board->data(), nullptr, &heights, bag, state);
+        return state.score;
+    });
+}
+
+// Forking a game (a plain copy), and taking and restoring its snapshot, on a
+// board part way through a game
+template <int W, int H>
+static void benchTetrisSnapshot(Bench &bench) {
+    using Engine = BasicTetrisEngine<W, H>;
+    const std::string size = "board=" + std::to_string(W) + "x" + std::to_string(H);
+    auto source = std::make_unique<Engine>(SEED);
+    std::uint32_t rng = SEED;
+    while (source->getPiecesSpawned() < H / 2 && !source->isGameOver()) {
+        source->step(static_cast<Action>(nextRandom(rng) % static_cast<unsigned>(Action::Count)));
+    }
+    auto fork = std::make_unique<Engine>(*source);
+    bench.run("tetrisCopy", size, [&] {
+        *fork = *source;
+        return fork->getScore();
+    });
+    auto snapshot = std::make_unique<typename Engine::Snapshot>(source->snapshot());
+    bench.run("tetrisSnapshot", size, [&] {
+        *snapshot = source->snapshot();
+        return snapshot->pieces;
+    });
+    bench.run("tetrisRestore", size, [&] {
+        return static_cast<int>(fork->restore(*snapshot));
+    });
+}
+
+static void benchSnake(Bench &bench, int width, int height, std::initializer_list<int> lengths) {
+    // The snake circles the top height - 1 rows forever; food is parked on
+    // the bottom row so its length never changes
+    const vector<Position> cycle = hamiltonianCycle(width, height - 1);
+    const int cells = static_cast<int>(cycle.size());
+    const Position parkedFood(0, height - 1);
+    // Standard-grid cases keep their old names, so earlier CSVs still line up
+    const bool standard = width == GRID_WIDTH && height == GRID_HEIGHT;
+    const std::string grid = standard ? "" : "grid=" + std::to_string(width) + "x" + std::to_string(height) + " ";
+
+    for (int length : lengths) {
+        const std::string param = grid + "length=" + std::to_string(length);
+        auto place = [&](SnakeEngine &game, int headIndex) {
+            vector<Position> body;
+            for (int i = 0; i < length; ++i) body.push_back(cycle[(headIndex - i + cells) % cells]);
+            game.setSnake(body, towards(body[1], body[0]));
+            game.setFood(parkedFood);
+        };
+
+        SnakeEngine game(width, height);
+        int head = length - 1;
+        place(game, head);
+        bench.run("moveSnake", param, [&] {
+            head = (head + 1) % cells;
+            game.steer(towards(game.getBody()[0], cycle[head]));
+            game.moveSnake();
+            return game.getBody()[0].x;
+        });
+
+        place(game, length - 1);
+        vector<Position> probes(1024);
+        std::uint32_t rng = SEED;
+        for (auto &p : probes) {
+            p = Position(static_cast<int>(nextRandom(rng) % width), static_cast<int>(nextRandom(rng) % height));
+        }
+        size_t i = 0;
+        bench.run("isSnakePosition", param, [&] {
+            return game.isSnakePosition(probes[i++ & 1023]);
+        });
+
+        bench.run("generateFood", param, [&] {
+            game.generateFood();
+            return game.getFood().x;
+        });
+
+        // One autopilot decision: path to the food and the tail check
+        place(game, length - 1);
+        SnakeAutopilot autopilot(width, height);
+        bench.run("autopilotDecide", param, [&] {
+            return static_cast<int>(autopilot.decide(game));
+        });
+
+        // Forking into an engine of the same grid reuses its memory
+        SnakeEngine fork(game);
+        bench.run("snakeCopy", param, [&] {
+            fork = game;
+            return fork.getScore();
+        });
+        SnakeSnapshotHeader header;
+        vector<std::uint32_t> snapshotCells(game.snapshotCells());
+        game.saveSnapshot(header, snapshotCells.data());
+        bench.run("snakeSnapshot", param, [&] {
+            game.saveSnapshot(header, snapshotCells.data());
+            return static_cast<int>(header.length);
+        });
+        bench.run("snakeRestore", param, [&] {
+            return static_cast<int>(fork.restoreSnapshot(header, snapshotCells.data()));
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    Bench bench("engine");
+    if (!bench.parseArgs(argc, argv)) return 1;
+    if (!checkFullRowSearch<10, 200>() || !checkFullRowSearch<32, 200>() || !checkFullRowSearch<64, 200>()) return 1;
+    benchTetris(bench);
+    benchWideTetris(bench);
+    benchTetrisSnapshot<COLS, ROWS>(bench);
+    benchTetrisSnapshot<64, 1000>(bench);
+    benchSnake(bench, GRID_WIDTH, GRID_HEIGHT, {3, 32, 128, 360});
+    benchSnake(bench, 512, 512, {1024, 65536, 250000});
+    return 0;
+}
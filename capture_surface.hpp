@@ -0,0 +1,57 @@
+// Frame capture for an SFML window, shared by both games. While capturing,
+// a frame is drawn into a RenderTexture, read back with glReadPixels straight
+// into a FrameCapture buffer and then copied onto the window; otherwise it
+// goes straight to the window and this costs nothing. The readback is
+// synchronous, but it allocates nothing: OpenGL returns the rows bottom up
+// and the writer thread flips them.
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+#include <cstdint>
+#include <string>
+#include "frame_capture.hpp"
+
+class CaptureSurface {
+public:
+    bool open(const std::string &path, CaptureFormat format, unsigned width, unsigned height) {
+        if (!texture.create(width, height)) return false;
+        sprite.setTexture(texture.getTexture(), true);
+        return capture.open(path, format, width, height, true);
+    }
+
+    bool isOpen() const { return capture.isOpen(); }
+
+    // Where this frame should be drawn
+    sf::RenderTarget &target(sf::RenderWindow &window) {
+        if (isOpen()) return texture;
+        return window;
+    }
+
+    // Hands the finished frame to the writer and puts it on the window. When
+    // the writer has every buffer the readback is skipped as well. Returns
+    // the number of draw calls issued.
+    int finishFrame(sf::RenderWindow &window) {
+        if (!isOpen()) return 0;
+        texture.display();
+        std::uint8_t *buffer = capture.acquire();
+        if (buffer && texture.setActive(true)) {
+            const sf::Vector2u size = texture.getSize();
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE,
+                         buffer);
+            texture.setActive(false);
+            capture.submit();
+        }
+        window.draw(sprite);
+        return 1;
+    }
+
+    // Flushes queued frames and prints the frame and drop counts
+    void close() { capture.close(); }
+
+private:
+    sf::RenderTexture texture;
+    sf::Sprite sprite;
+    FrameCapture capture;
+};
@@ -0,0 +1,8 @@
+// Byte array for the embedded font. font_data.inc is generated from
+// assets/DejaVuSans.ttf by the Makefile (xxd -i).
+#include "embedded_font.hpp"
+
+const unsigned char EMBEDDED_FONT[] = {
+#include "font_data.inc"
+};
+const std::size_t EMBEDDED_FONT_SIZE = sizeof(EMBEDDED_FONT);
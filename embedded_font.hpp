@@ -0,0 +1,24 @@
+// Font compiled into the binary (assets/DejaVuSans.ttf, see Makefile), so
+// the games never depend on a system font path.
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <initializer_list>
+
+extern const unsigned char EMBEDDED_FONT[];
+extern const std::size_t EMBEDDED_FONT_SIZE;
+
+inline bool loadEmbeddedFont(sf::Font &font) {
+    return font.loadFromMemory(EMBEDDED_FONT, EMBEDDED_FONT_SIZE);
+}
+
+// Rasterises printable ASCII plus the arrow glyphs at each size up front, so
+// the glyph atlas is complete before the first frame is drawn.
+inline void prewarmGlyphs(const sf::Font &font, std::initializer_list<unsigned> sizes, bool bold) {
+    static constexpr sf::Uint32 extra[] = {0x2190, 0x2191, 0x2192, 0x2193}; // ← ↑ → ↓
+    for (unsigned size : sizes) {
+        for (sf::Uint32 c = 0x20; c < 0x7F; ++c) font.getGlyph(c, size, bold);
+        for (sf::Uint32 c : extra) font.getGlyph(c, size, bold);
+    }
+}
@@ -0,0 +1,216 @@
+// Records rendered frames to disk without holding up the game loop. The game
+// thread reads each frame back into one of a fixed pool of buffers and
+// queues it; a writer thread puts its rows in order, encodes and writes it,
+// then hands the buffer back. Both
+// hand-offs go through lock-free queues, so neither side waits for the other.
+// When the writer has every buffer, the frame is dropped and counted.
+//
+// Formats:
+//   ppm  one binary P6 file per frame, DIR/frame-NNNNNN.ppm. Frames are
+//        numbered by game frame, so gaps in the numbering are drops.
+//   rle  one file: "FRLE", u32 width, u32 height, then for each frame
+//        u32 frame number, u32 run count and that many runs of
+//        (u8 length - 1, r, g, b). Integers are little-endian.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+
+enum class CaptureFormat { Ppm, Rle };
+
+inline bool parseCaptureFormat(const std::string &name, CaptureFormat &format) {
+    if (name == "ppm") format = CaptureFormat::Ppm;
+    else if (name == "rle") format = CaptureFormat::Rle;
+    else return false;
+    return true;
+}
+
+class FrameCapture {
+public:
+    static constexpr int POOL_SIZE = 8; // frames that can be in flight at once
+
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+    ~FrameCapture() { close(); }
+
+    // `path` is a directory for ppm, which must exist, and a file for rle.
+    // bottomUp says frames arrive bottom row first, as OpenGL reads them back.
+    // Allocates every buffer up front and starts the writer.
+    bool open(const std::string &path, CaptureFormat format, unsigned width, unsigned height, bool bottomUp = false) {
+        close();
+        this->path = path;
+        this->format = format;
+        this->width = width;
+        this->height = height;
+        this->bottomUp = bottomUp;
+        if (format == CaptureFormat::Rle) {
+            stream = std::fopen(path.c_str(), "wb");
+            if (!stream) return false;
+            std::fwrite("FRLE", 1, 4, stream);
+            writeU32(width);
+            writeU32(height);
+        }
+        const std::size_t bytes = std::size_t(width) * height * 4;
+        pool.assign(POOL_SIZE, std::vector<std::uint8_t>(bytes));
+        encoded.reserve(bytes);
+        for (int i = 0; i < POOL_SIZE; ++i) freeSlots.push(i);
+        pending = -1;
+        offered = dropped = 0;
+        written = writeErrors = 0;
+        writeSeconds = 0;
+        stopping = false;
+        writer = std::thread([this] { writerLoop(); });
+        return true;
+    }
+
+    bool isOpen() const { return writer.joinable(); }
+
+    // Game thread, once per frame. Returns a width * height RGBA buffer, rows
+    // in the order given to open(), to fill and submit(); or nullptr when the
+    // writer still has every buffer, in which case the frame is counted as
+    // dropped.
+    std::uint8_t *acquire() {
+        frameNumber = offered++;
+        if (pending < 0 && !freeSlots.pop(pending)) {
+            ++dropped;
+            return nullptr;
+        }
+        return pool[pending].data();
+    }
+
+    // Game thread: queues the buffer from the last acquire()
+    void submit() {
+        if (pending < 0) return;
+        filledFrames.push(Frame{pending, frameNumber});
+        pending = -1;
+    }
+
+    // Writes out everything already queued, stops the writer and reports
+    void close() {
+        if (!writer.joinable()) return;
+        stopping = true;
+        writer.join();
+        if (stream) std::fclose(stream);
+        stream = nullptr;
+        report();
+        // Buffers go back to the pool for a later open()
+        int slot;
+        while (freeSlots.pop(slot)) {}
+    }
+
+    std::uint64_t framesOffered() const { return offered; }
+    std::uint64_t framesDropped() const { return dropped; }
+    std::uint64_t framesWritten() const { return written.load(); }
+
+private:
+    struct Frame {
+        int slot = -1;
+        std::uint64_t number = 0;
+    };
+
+    std::string path;
+    CaptureFormat format = CaptureFormat::Ppm;
+    unsigned width = 0, height = 0;
+    bool bottomUp = false;
+    std::vector<std::vector<std::uint8_t>> pool;
+    SpscQueue<Frame, POOL_SIZE> filledFrames; // game thread -> writer
+    SpscQueue<int, POOL_SIZE> freeSlots;      // writer -> game thread
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+
+    // Game thread only
+    int pending = -1;
+    std::uint64_t frameNumber = 0, offered = 0, dropped = 0;
+
+    // Writer only, read after it has been joined
+    std::FILE *stream = nullptr;
+    std::vector<std::uint8_t> encoded;
+    std::atomic<std::uint64_t> written{0};
+    std::uint64_t writeErrors = 0;
+    double writeSeconds = 0;
+
+    void writerLoop() {
+        for (;;) {
+            Frame frame;
+            if (!filledFrames.pop(frame)) {
+                if (stopping) {
+                    if (!filledFrames.pop(frame)) return;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+            }
+            const auto start = std::chrono::steady_clock::now();
+            if (bottomUp) flipRows(pool[frame.slot].data());
+            const bool ok = format == CaptureFormat::Ppm ? writePpm(frame) : writeRle(frame);
+            writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (ok) ++written;
+            else ++writeErrors;
+            freeSlots.push(frame.slot);
+        }
+    }
+
+    // Swaps rows top for bottom in place
+    void flipRows(std::uint8_t *rgba) const {
+        const std::size_t stride = std::size_t(width) * 4;
+        for (unsigned y = 0; y < height / 2; ++y) {
+            std::uint8_t *top = rgba + y * stride;
+            std::swap_ranges(top, top + stride, rgba + (height - 1 - y) * stride);
+        }
+    }
+
+    bool writePpm(const Frame &frame) {
+        char name[32];
+        std::snprintf(name, sizeof name, "/frame-%06llu.ppm", static_cast<unsigned long long>(frame.number));
+        std::FILE *f = std::fopen((path + name).c_str(), "wb");
+        if (!f) return false;
+        const std::uint8_t *rgba = pool[frame.slot].data();
+        const std::size_t pixels = std::size_t(width) * height;
+        encoded.resize(pixels * 3);
+        for (std::size_t i = 0; i < pixels; ++i) std::memcpy(&encoded[i * 3], rgba + i * 4, 3);
+        std::fprintf(f, "P6\n%u %u\n255\n", width, height);
+        const bool ok = std::fwrite(encoded.data(), 1, encoded.size(), f) == encoded.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    bool writeRle(const Frame &frame) {
+        const std::uint8_t *rgba = pool[frame.slot].data();
+        const std::size_t pixels = std::size_t(width) * height;
+        encoded.clear();
+        std::uint32_t runs = 0;
+        for (std::size_t i = 0; i < pixels;) {
+            const std::uint8_t *p = rgba + i * 4;
+            std::size_t n = 1;
+            while (n < 256 && i + n < pixels && std::memcmp(p, p + n * 4, 3) == 0) ++n;
+            encoded.push_back(static_cast<std::uint8_t>(n - 1));
+            encoded.insert(encoded.end(), p, p + 3);
+            ++runs;
+            i += n;
+        }
+        return writeU32(static_cast<std::uint32_t>(frame.number)) && writeU32(runs) &&
+               std::fwrite(encoded.data(), 1, encoded.size(), stream) == encoded.size();
+    }
+
+    bool writeU32(std::uint32_t v) {
+        const std::uint8_t bytes[4] = {std::uint8_t(v), std::uint8_t(v >> 8), std::uint8_t(v >> 16), std::uint8_t(v >> 24)};
+        return std::fwrite(bytes, 1, 4, stream) == 4;
+    }
+
+    void report() const {
+        const std::uint64_t w = written.load();
+        std::fprintf(stderr, "capture %s: frames=%llu written=%llu dropped=%llu (%.1f%%) write-errors=%llu mean-write=%.2fms\n",
+                     path.c_str(), static_cast<unsigned long long>(offered), static_cast<unsigned long long>(w),
+                     static_cast<unsigned long long>(dropped), offered ? 100.0 * dropped / offered : 0.0,
+                     static_cast<unsigned long long>(writeErrors), w ? writeSeconds * 1000 / w : 0.0);
+    }
+};
@@ -0,0 +1,70 @@
+// Timestamped input queue. Inputs are stamped on arrival and handed to the
+// simulation one per step, so several quick key presses between two steps
+// each get a step of their own instead of overwriting one another. The ring
+// is an SpscQueue: the event pump may run on its own thread without locks.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include "spsc_queue.hpp"
+#include "timestep.hpp"
+
+template <typename T, std::size_t Capacity>
+class TimedInputQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Producer only. Returns false, dropping the input, when full.
+    bool push(const T &input, Clock::time_point received = Clock::now()) {
+        if (!ring.push(Entry{input, received})) {
+            ++dropped;
+            return false;
+        }
+        lastPushed = input;
+        return true;
+    }
+
+    // Producer only: the newest input still waiting, if any
+    bool back(T &out) const {
+        if (ring.size() == 0) return false;
+        out = lastPushed;
+        return true;
+    }
+
+    // Consumer only. Takes the oldest input and records how long it waited.
+    bool pop(T &out, Clock::time_point now = Clock::now()) {
+        Entry e;
+        if (!ring.pop(e)) return false;
+        waits.add(std::chrono::duration<double, std::milli>(now - e.received).count());
+        out = e.input;
+        return true;
+    }
+
+    // Consumer only. Discards everything waiting, e.g. on a new game.
+    void clear() {
+        Entry e;
+        while (ring.pop(e)) {}
+    }
+
+    std::size_t size() const { return ring.size(); }
+    LatencyWindow::Stats waitStats() const { return waits.stats(); }
+
+    void report(const char *name) const {
+        const LatencyWindow::Stats s = waits.stats();
+        if (s.count == 0 && dropped == 0) return;
+        std::fprintf(stderr, "%s input wait: inputs=%zu dropped=%zu mean=%.1fms p50=%.1fms p99=%.1fms max=%.1fms\n",
+                     name, s.count, dropped, s.meanMs, s.p50Ms, s.p99Ms, s.maxMs);
+    }
+
+private:
+    struct Entry {
+        T input;
+        Clock::time_point received;
+    };
+
+    SpscQueue<Entry, Capacity> ring;
+    T lastPushed{};
+    std::size_t dropped = 0; // producer side
+    LatencyWindow waits;     // consumer side
+};
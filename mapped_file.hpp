@@ -0,0 +1,79 @@
+// Read-only memory mapping of a whole file (POSIX mmap)
+#pragma once
+
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const char *path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept : ptr(other.ptr), length(other.length), opened(other.opened) {
+        other.ptr = nullptr;
+        other.length = 0;
+        other.opened = false;
+    }
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            close();
+            ptr = other.ptr;
+            length = other.length;
+            opened = other.opened;
+            other.ptr = nullptr;
+            other.length = 0;
+            other.opened = false;
+        }
+        return *this;
+    }
+
+    // Maps the file, hinting sequential access. Empty files open with a null
+    // data() and size() 0.
+    bool open(const char *path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        opened = true;
+        length = static_cast<std::size_t>(st.st_size);
+        if (length > 0) {
+            void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                opened = false;
+                length = 0;
+                return false;
+            }
+            ptr = static_cast<const unsigned char *>(p);
+            madvise(p, length, MADV_SEQUENTIAL);
+        }
+        ::close(fd); // the mapping keeps the file alive
+        return true;
+    }
+
+    void close() {
+        if (ptr) munmap(const_cast<unsigned char *>(ptr), length);
+        ptr = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+    bool isOpen() const { return opened; }
+    const unsigned char *data() const { return ptr; }
+    std::size_t size() const { return length; }
+
+private:
+    const unsigned char *ptr = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+};
@@ -0,0 +1,145 @@
+// Per-phase frame profiler. ScopedPhase timers add up the time spent in each
+// phase of a frame, endFrame() closes the frame, and the last WINDOW frames
+// give rolling p50/p99 figures. The last MAX_ROWS frames are also kept, in a
+// ring allocated up front so nothing allocates inside the frame loop, for a
+// CSV dump.
+// While disabled, timers skip the clock entirely and endFrame() returns at
+// once, so leaving the hooks in costs a branch each.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <vector>
+
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int MAX_PHASES = 6;
+    static constexpr std::size_t WINDOW = 240;  // frames in the rolling figures
+    static constexpr std::size_t MAX_ROWS = 1 << 16; // frames kept for the CSV: 18 minutes at 60 fps, 2 MB
+
+    struct Percentiles {
+        double p50 = 0, p99 = 0;
+    };
+
+    explicit FrameProfiler(std::initializer_list<const char *> names) : rows(MAX_ROWS) {
+        for (const char *n : names) {
+            if (phaseCount == MAX_PHASES) break;
+            phaseNames[phaseCount++] = n;
+        }
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    void setEnabled(bool on) {
+        if (on && !enabled) frameStart = Clock::now();
+        enabled = on;
+        current = Row();
+    }
+
+    int phases() const { return phaseCount; }
+    const char *phaseName(int phase) const { return phaseNames[phase]; }
+
+    void addTime(int phase, Clock::duration d) {
+        current.phaseUs[phase] += std::chrono::duration<float, std::micro>(d).count();
+    }
+
+    void countDraws(int n) {
+        if (enabled) current.draws += static_cast<std::uint32_t>(n);
+    }
+
+    // Closes the frame: its total is the time since the previous endFrame()
+    void endFrame() {
+        if (!enabled) return;
+        const Clock::time_point now = Clock::now();
+        current.frameUs = std::chrono::duration<float, std::micro>(now - frameStart).count();
+        frameStart = now;
+        recent[next] = current;
+        next = (next + 1) % WINDOW;
+        filled = std::min(filled + 1, WINDOW);
+        rows[frames++ % MAX_ROWS] = current;
+        current = Row();
+    }
+
+    // Rolling figures in milliseconds; phase -1 is the whole frame
+    Percentiles phaseMs(int phase) const {
+        return percentiles([phase](const Row &r) {
+            return (phase < 0 ? r.frameUs : r.phaseUs[phase]) / 1000.0f;
+        });
+    }
+
+    Percentiles drawCalls() const {
+        return percentiles([](const Row &r) { return static_cast<float>(r.draws); });
+    }
+
+    std::size_t framesRecorded() const { return frames; }
+
+    // One line per kept frame, oldest first, times in microseconds
+    bool writeCsv(const char *path) const {
+        std::FILE *f = std::fopen(path, "w");
+        if (!f) return false;
+        std::fprintf(f, "frame");
+        for (int p = 0; p < phaseCount; ++p) std::fprintf(f, ",%s_us", phaseNames[p]);
+        std::fprintf(f, ",frame_us,draw_calls\n");
+        for (std::size_t i = frames > MAX_ROWS ? frames - MAX_ROWS : 0; i < frames; ++i) {
+            const Row &r = rows[i % MAX_ROWS];
+            std::fprintf(f, "%zu", i);
+            for (int p = 0; p < phaseCount; ++p) std::fprintf(f, ",%.1f", r.phaseUs[p]);
+            std::fprintf(f, ",%.1f,%u\n", r.frameUs, r.draws);
+        }
+        return std::fclose(f) == 0;
+    }
+
+private:
+    struct Row {
+        std::array<float, MAX_PHASES> phaseUs{};
+        float frameUs = 0;
+        std::uint32_t draws = 0;
+    };
+
+    std::array<const char *, MAX_PHASES> phaseNames{};
+    int phaseCount = 0;
+    bool enabled = false;
+    Row current;
+    Clock::time_point frameStart;
+    std::array<Row, WINDOW> recent{};
+    std::size_t next = 0, filled = 0;
+    std::vector<Row> rows;  // ring of MAX_ROWS
+    std::size_t frames = 0; // recorded in all
+
+    template <typename Value>
+    Percentiles percentiles(Value value) const {
+        Percentiles out;
+        if (filled == 0) return out;
+        std::array<float, WINDOW> v;
+        for (std::size_t i = 0; i < filled; ++i) v[i] = value(recent[i]);
+        std::sort(v.begin(), v.begin() + filled);
+        out.p50 = v[filled / 2];
+        out.p99 = v[std::min(filled - 1, filled * 99 / 100)];
+        return out;
+    }
+};
+
+// Adds the time until the end of the scope to one phase of the current frame
+class ScopedPhase {
+public:
+    ScopedPhase(FrameProfiler &profiler, int phase)
+        : profiler(profiler.isEnabled() ? &profiler : nullptr), phase(phase) {
+        if (this->profiler) start = FrameProfiler::Clock::now();
+    }
+    ~ScopedPhase() {
+        if (profiler) profiler->addTime(phase, FrameProfiler::Clock::now() - start);
+    }
+    ScopedPhase(const ScopedPhase &) = delete;
+    ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+private:
+    FrameProfiler *profiler;
+    int phase;
+    FrameProfiler::Clock::time_point start;
+};
@@ -0,0 +1,54 @@
+// On-screen view of a FrameProfiler, shared by both games (F3 toggles it)
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdio>
+#include <string>
+#include "profiler.hpp"
+
+class ProfilerOverlay {
+public:
+    static constexpr unsigned TEXT_SIZE = 14;
+
+    void init(const sf::Font &font, float x, float y) {
+        text.setFont(font);
+        text.setCharacterSize(TEXT_SIZE);
+        text.setFillColor(sf::Color(220, 255, 220));
+        text.setPosition(x + 6, y + 4);
+        background.setPosition(x, y);
+        background.setFillColor(sf::Color(0, 0, 0, 190));
+    }
+
+    // Rebuilds the text from the rolling figures a few times a second rather
+    // than every frame, so the numbers stay readable
+    void update(const FrameProfiler &profiler) {
+        if (framesSinceRefresh++ % REFRESH_FRAMES != 0) return;
+        std::string s;
+        char line[96];
+        auto add = [&](const char *name, FrameProfiler::Percentiles p, const char *unit) {
+            std::snprintf(line, sizeof line, "%-8s p50 %6.2f  p99 %6.2f %s\n", name, p.p50, p.p99, unit);
+            s += line;
+        };
+        add("frame", profiler.phaseMs(-1), "ms");
+        for (int p = 0; p < profiler.phases(); ++p) add(profiler.phaseName(p), profiler.phaseMs(p), "ms");
+        add("draws", profiler.drawCalls(), "");
+        s.pop_back();
+        text.setString(s);
+        const sf::FloatRect bounds = text.getLocalBounds();
+        background.setSize({bounds.left + bounds.width + 12, bounds.top + bounds.height + 10});
+    }
+
+    // Returns the number of draw calls issued
+    int draw(sf::RenderTarget &rt) const {
+        rt.draw(background);
+        rt.draw(text);
+        return 2;
+    }
+
+private:
+    static constexpr unsigned REFRESH_FRAMES = 15;
+
+    sf::RectangleShape background;
+    sf::Text text;
+    unsigned framesSinceRefresh = 0;
+};
@@ -1,53 +1,123 @@
 #include <SFML/Graphics.hpp>
-#include <vector>
-#include <cstdlib>
-#include <ctime>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "snake_engine.hpp"
+#include "snake_render.hpp"
+#include "snake_world_render.hpp"
+#include "snake_ai.hpp"
+#include "embedded_font.hpp"
+#include "timestep.hpp"
+#include "input_queue.hpp"
+#include "snapshot_file.hpp"
+#include "telemetry.hpp"
+#include "profiler_overlay.hpp"
+#include "capture_surface.hpp"
 
 using namespace std;
 using namespace sf;
 
-const int CELL_SIZE = 30;
-const int GRID_WIDTH = 20;
-const int GRID_HEIGHT = 20;
-const int WINDOW_WIDTH = CELL_SIZE * GRID_WIDTH;
-const int WINDOW_HEIGHT = CELL_SIZE * GRID_HEIGHT + 80; // Extra space for score and instructions
 const float GAME_SPEED = 0.15f; // seconds per move
+// --speed bounds, in seconds per move
+const float MIN_SPEED = 0.0005f, MAX_SPEED = 2.0f;
 const int WINDOW_STYLE = Style::Titlebar | Style::Close;
+// --grid bounds; the engine keeps about 8 bytes per cell
+const int MIN_GRID = 5, MAX_GRID = 10000;
+// Turns that can wait for upcoming moves; one more key press is dropped
+const size_t MAX_QUEUED_TURNS = 4;
 
-enum Direction { UP, DOWN, LEFT, RIGHT, NONE };
+// Frame phases timed by the profiler
+const int PHASE_INPUT = 0, PHASE_MOVE = 1, PHASE_DRAW = 2, PHASE_CAPTURE = 3, PHASE_DISPLAY = 4;
 
-struct Position {
-    int x, y;
-    Position(int x = 0, int y = 0) : x(x), y(y) {}
-    bool operator==(const Position& other) const {
-        return x == other.x && y == other.y;
-    }
+struct GameOptions {
+    uint64_t seed = 0;
+    int gridWidth = GRID_WIDTH;   // any other size plays in a scrolling world view
+    int gridHeight = GRID_HEIGHT;
+    string profilePath; // profile every frame from the start and write the CSV here
+    string capturePath; // record every frame here when set
+    CaptureFormat captureFormat = CaptureFormat::Ppm;
+    float moveSeconds = GAME_SPEED;
+    bool autopilot = false;
+    string resumePath; // resume the game saved here, and save it here on exit
+    string telemetryPath; // log gameplay events here when set
 };
 
 class SnakeGame {
 private:
     RenderWindow window;
-    vector<Position> snake;
-    Position food;
-    Direction dir;
-    Direction nextDir;
-    bool gameOver;
-    int score;
-    Clock gameClock;
+    Font font;
+    SnakeEngine engine;
+    bool world;         // grid other than the standard one: camera and chunked drawing
+    SnakeRenderer renderer{font};
+    SnakeWorldRenderer worldRenderer{font};
+    FixedTimestep timestep;
+    unique_ptr<SnakeAutopilot> autopilot; // built when first switched on: about 14 bytes per cell
+    bool autopilotOn;
+    int autopilotGames = 0;
+    long movesSinceFood = 0;
+    TimedInputQueue<Direction, MAX_QUEUED_TURNS> turns;
+    LatencyTracker latency;
+    FrameProfiler profiler{"input", "move", "draw", "capture", "display"};
+    ProfilerOverlay profilerOverlay;
+    bool showProfiler = false;
+    string profilePath;
+    bool profileAlways;     // keep profiling while the overlay is hidden
+    CaptureSurface capture;
+    SnapshotWriter snapshot;
+    TelemetryLog telemetry;
+    SnakeTelemetry events{telemetry};
 
-    void generateFood() {
-        do {
-            food.x = rand() % GRID_WIDTH;
-            food.y = rand() % GRID_HEIGHT;
-        } while (isSnakePosition(food));
+    size_t snapshotBytes() const {
+        return sizeof(SnakeSnapshotHeader) + engine.snapshotCells() * sizeof(uint32_t);
     }
 
-    bool isSnakePosition(const Position& pos) {
-        for (const auto& segment : snake) {
-            if (segment == pos) return true;
+    // Picks up the unfinished game saved in path, if there is one for this
+    // grid, and keeps the file mapped to save this game into on exit
+    void resume(const string& path) {
+        {
+            MappedFile file(path.c_str());
+            size_t size = 0;
+            const unsigned char* payload = snapshotPayload(file, SNAPSHOT_SNAKE, size);
+            SnakeSnapshotHeader header;
+            if (payload && size == snapshotBytes()) {
+                memcpy(&header, payload, sizeof header);
+                // The cells start 4-byte aligned: a slot's payload is cache-line aligned plus 32
+                if (!header.gameOver &&
+                    !engine.restoreSnapshot(header, reinterpret_cast<const uint32_t*>(payload + sizeof header))) {
+                    fprintf(stderr, "%s holds no snake game to resume\n", path.c_str());
+                }
+            } else if (file.size() > 0) {
+                fprintf(stderr, "%s holds no snake game on a %dx%d grid to resume\n", path.c_str(),
+                        engine.getWidth(), engine.getHeight());
+            }
+        }
+        if (!snapshot.open(path.c_str(), SNAPSHOT_SNAKE, snapshotBytes())) {
+            fprintf(stderr, "cannot save the game to %s: not a snake save file of this grid size\n", path.c_str());
         }
-        return false;
+    }
+
+    // Writes the engine straight into the mapped snapshot file
+    void save() {
+        if (!snapshot.isOpen()) return;
+        SnakeSnapshotHeader header;
+        engine.saveSnapshot(header, reinterpret_cast<uint32_t*>(snapshot.payload() + sizeof header));
+        memcpy(snapshot.payload(), &header, sizeof header);
+        snapshot.commit();
+    }
+
+    // Queues a turn for an upcoming move, one turn per move. Each is checked
+    // against the turn before it, so a quick up-then-left both take effect.
+    // Its latency runs until that move is shown.
+    void steer(Direction d) {
+        if (autopilotOn || engine.isGameOver()) return;
+        Direction previous;
+        if (!turns.back(previous)) previous = engine.getDirection();
+        if (d == previous || d == SnakeEngine::opposite(previous)) return;
+        if (turns.push(d)) latency.inputReceived();
     }
 
     void handleInput() {
@@ -55,30 +125,39 @@ private:
         while (window.pollEvent(event)) {
             if (event.type == Event::Closed) {
                 window.close();
-                gameOver = true;
             }
 
             if (event.type == Event::KeyPressed) {
                 switch (event.key.code) {
                     case Keyboard::Up:
                     case Keyboard::W:
-                        if (dir != DOWN) nextDir = UP;
+                        steer(UP);
                         break;
                     case Keyboard::Down:
                     case Keyboard::S:
-                        if (dir != UP) nextDir = DOWN;
+                        steer(DOWN);
                         break;
                     case Keyboard::Left:
                     case Keyboard::A:
-                        if (dir != RIGHT) nextDir = LEFT;
+                        steer(LEFT);
                         break;
                     case Keyboard::Right:
                     case Keyboard::D:
-                        if (dir != LEFT) nextDir = RIGHT;
+                        steer(RIGHT);
+                        break;
+                    case Keyboard::Tab:
+                        autopilotOn = !autopilotOn;
+                        if (autopilotOn && !autopilot) {
+                            autopilot = make_unique<SnakeAutopilot>(engine.getWidth(), engine.getHeight());
+                        }
+                        turns.clear();
+                        break;
+                    case Keyboard::F3:
+                        showProfiler = !showProfiler;
+                        profiler.setEnabled(showProfiler || profileAlways);
                         break;
                     case Keyboard::Escape:
                         window.close();
-                        gameOver = true;
                         break;
                     default:
                         break;
@@ -88,177 +167,153 @@ private:
     }
 
     void moveSnake() {
-        if (nextDir != NONE) {
-            dir = nextDir;
-            nextDir = NONE;
-        }
-
-        Position head = snake[0];
-        
-        switch (dir) {
-            case UP:
-                head.y--;
-                break;
-            case DOWN:
-                head.y++;
-                break;
-            case LEFT:
-                head.x--;
-                break;
-            case RIGHT:
-                head.x++;
-                break;
-            default:
-                return;
-        }
-
-        // Check wall collision
-        if (head.x < 0 || head.x >= GRID_WIDTH || head.y < 0 || head.y >= GRID_HEIGHT) {
-            gameOver = true;
-            return;
-        }
-
-        // Check self collision
-        if (isSnakePosition(head)) {
-            gameOver = true;
-            return;
-        }
-
-        snake.insert(snake.begin(), head);
+        Direction d;
+        const bool turning = turns.pop(d) && engine.steer(d);
+        if (autopilotOn) engine.steer(autopilot->decide(engine));
+        engine.moveSnake();
+        events.moved(engine);
+        movesSinceFood = engine.ateFood() ? 0 : movesSinceFood + 1;
+        if (world) worldRenderer.noteMove(engine);
+        else renderer.noteMove(engine);
+        if (turning) latency.inputApplied();
+    }
 
-        // Check food collision
-        if (head == food) {
-            score++;
-            generateFood();
-        } else {
-            snake.pop_back();
-        }
+    // Unattended play: a game the autopilot lost, or can no longer win, is
+    // logged and replaced by a new one
+    void restartAutopilotGame() {
+        const bool stalled = !engine.isGameOver();
+        fprintf(stderr, "autopilot game %d: score %d, length %zu of %d cells, %s\n", ++autopilotGames,
+                engine.getScore(), engine.getBody().size(), engine.getWidth() * engine.getHeight(),
+                stalled ? "stalled" : "died");
+        engine.reset();
+        events.start(engine);
+        renderer.invalidate();
+        worldRenderer.invalidate();
+        turns.clear();
+        movesSinceFood = 0;
     }
 
     void draw() {
-        window.clear(Color(30, 30, 30)); // Dark gray background
+        ScopedPhase timer(profiler, PHASE_DRAW);
+        RenderTarget& target = capture.target(window);
+        int draws = 0;
+        target.clear(Color(30, 30, 30)); // Dark gray background
 
-        // Draw game area border
-        RectangleShape gameArea(Vector2f(WINDOW_WIDTH, CELL_SIZE * GRID_HEIGHT));
-        gameArea.setFillColor(Color::Transparent);
-        gameArea.setOutlineColor(Color(100, 100, 100));
-        gameArea.setOutlineThickness(2);
-        gameArea.setPosition(0, 0);
-        window.draw(gameArea);
+        if (world) draws += worldRenderer.draw(target, engine, timestep.alpha());
+        else draws += renderer.draw(target, engine, timestep.alpha());
 
-        // Draw food
-        RectangleShape foodRect(Vector2f(CELL_SIZE - 2, CELL_SIZE - 2));
-        foodRect.setPosition(food.x * CELL_SIZE + 1, food.y * CELL_SIZE + 1);
-        foodRect.setFillColor(Color(255, 50, 50)); // Red
-        window.draw(foodRect);
-
-        // Draw snake
-        for (size_t i = 0; i < snake.size(); i++) {
-            RectangleShape segment(Vector2f(CELL_SIZE - 2, CELL_SIZE - 2));
-            int x = snake[i].x * CELL_SIZE + 1;
-            int y = snake[i].y * CELL_SIZE + 1;
-            segment.setPosition(x, y);
-            
-            if (i == 0) {
-                segment.setFillColor(Color(50, 255, 50)); // Bright green for head
-            } else {
-                segment.setFillColor(Color(0, 200, 0)); // Darker green for body
-            }
-            window.draw(segment);
+        if (showProfiler) {
+            profilerOverlay.update(profiler);
+            draws += profilerOverlay.draw(target);
         }
+        profiler.countDraws(draws);
+    }
 
-        // Draw score and instructions
-        Text scoreText;
-        scoreText.setString("Score: " + to_string(score));
-        scoreText.setCharacterSize(20);
-        scoreText.setFillColor(Color::White);
-        scoreText.setPosition(10, CELL_SIZE * GRID_HEIGHT + 5);
-        window.draw(scoreText);
-
-        Text instructionsText;
-        instructionsText.setString("Use Arrow Keys or WASD to move | ESC to quit");
-        instructionsText.setCharacterSize(14);
-        instructionsText.setFillColor(Color(200, 200, 200));
-        instructionsText.setPosition(10, CELL_SIZE * GRID_HEIGHT + 30);
-        window.draw(instructionsText);
-
-        // Draw game over message
-        if (gameOver) {
-            RectangleShape overlay(Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
-            overlay.setFillColor(Color(0, 0, 0, 220)); // Semi-transparent black
-            window.draw(overlay);
-
-            Text gameOverText;
-            gameOverText.setString("GAME OVER!");
-            gameOverText.setCharacterSize(36);
-            gameOverText.setFillColor(Color::Red);
-            gameOverText.setStyle(Text::Bold);
-            FloatRect textRect = gameOverText.getLocalBounds();
-            gameOverText.setOrigin(textRect.left + textRect.width / 2.0f,
-                                 textRect.top + textRect.height / 2.0f);
-            gameOverText.setPosition(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f - 30);
-            window.draw(gameOverText);
-
-            Text scoreFinalText;
-            scoreFinalText.setString("Final Score: " + to_string(score));
-            scoreFinalText.setCharacterSize(24);
-            scoreFinalText.setFillColor(Color::White);
-            textRect = scoreFinalText.getLocalBounds();
-            scoreFinalText.setOrigin(textRect.left + textRect.width / 2.0f,
-                                   textRect.top + textRect.height / 2.0f);
-            scoreFinalText.setPosition(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f + 10);
-            window.draw(scoreFinalText);
-
-            Text exitText;
-            exitText.setString("Press ESC or close window to exit");
-            exitText.setCharacterSize(16);
-            exitText.setFillColor(Color(180, 180, 180));
-            textRect = exitText.getLocalBounds();
-            exitText.setOrigin(textRect.left + textRect.width / 2.0f,
-                             textRect.top + textRect.height / 2.0f);
-            exitText.setPosition(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f + 45);
-            window.draw(exitText);
+    void present() {
+        {
+            ScopedPhase timer(profiler, PHASE_CAPTURE);
+            profiler.countDraws(capture.finishFrame(window));
         }
-
-        window.display();
+        {
+            ScopedPhase timer(profiler, PHASE_DISPLAY);
+            window.display();
+        }
+        latency.framePresented();
     }
 
 public:
-    SnakeGame() : window(VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Snake Game", WINDOW_STYLE),
-                  dir(RIGHT), nextDir(NONE), gameOver(false), score(0) {
-        window.setFramerateLimit(60); // Smooth rendering
+    explicit SnakeGame(const GameOptions& options)
+        : engine(options.gridWidth, options.gridHeight, options.seed),
+          world(options.gridWidth != GRID_WIDTH || options.gridHeight != GRID_HEIGHT),
+          // Catch up at most a quarter of a second of moves after a stall
+          timestep(options.moveSeconds, max(16, static_cast<int>(0.25f / options.moveSeconds))),
+          autopilot(options.autopilot ? make_unique<SnakeAutopilot>(options.gridWidth, options.gridHeight) : nullptr),
+          autopilotOn(options.autopilot),
+          profilePath(options.profilePath.empty() ? "snake-profile.csv" : options.profilePath),
+          profileAlways(!options.profilePath.empty()) {
+        // Load the font and rasterise its glyphs before the window opens
+        loadEmbeddedFont(font);
+        prewarmGlyphs(font, {14, 16, 20, 24}, false);
+        prewarmGlyphs(font, {36}, true);
+        profilerOverlay.init(font, 4, 4);
+        profiler.setEnabled(profileAlways);
+        if (!options.resumePath.empty()) resume(options.resumePath);
+        if (!options.telemetryPath.empty() && !telemetry.open(options.telemetryPath)) {
+            fprintf(stderr, "cannot write telemetry to %s\n", options.telemetryPath.c_str());
+        }
+        events.start(engine);
+
+        const unsigned width = world ? WORLD_VIEW_WIDTH : WINDOW_WIDTH;
+        const unsigned height = world ? WORLD_WINDOW_HEIGHT : WINDOW_HEIGHT;
+        window.create(VideoMode(width, height), "Snake Game", WINDOW_STYLE);
+        window.setVerticalSyncEnabled(true); // Draw at the display's own rate
         window.setKeyRepeatEnabled(false); // Prevent key repeat
+        if (!options.capturePath.empty() && !capture.open(options.capturePath, options.captureFormat, width, height)) {
+            fprintf(stderr, "cannot capture to %s\n", options.capturePath.c_str());
+        }
         
-        // Initialize snake in the center
-        snake.push_back(Position(GRID_WIDTH / 2, GRID_HEIGHT / 2));
-        snake.push_back(Position(GRID_WIDTH / 2 - 1, GRID_HEIGHT / 2));
-        snake.push_back(Position(GRID_WIDTH / 2 - 2, GRID_HEIGHT / 2));
-        
-        generateFood();
-        srand(time(0));
-        gameClock.restart();
+        timestep.reset();
     }
 
     void run() {
         // Main game loop - window runs independently
         while (window.isOpen()) {
-            handleInput();
+            {
+                ScopedPhase timer(profiler, PHASE_INPUT);
+                handleInput();
+            }
             
-            if (!gameOver) {
-                // Move snake at fixed intervals
-                if (gameClock.getElapsedTime().asSeconds() >= GAME_SPEED) {
-                    moveSnake();
-                    gameClock.restart();
-                }
+            if (!engine.isGameOver()) {
+                // Moves run at a fixed rate however often frames are drawn
+                ScopedPhase timer(profiler, PHASE_MOVE);
+                const int steps = timestep.advance();
+                for (int i = 0; i < steps && !engine.isGameOver(); ++i) moveSnake();
+            }
+            if (autopilotOn && (engine.isGameOver() ||
+                                movesSinceFood > autopilotStallLimit(engine.getWidth(), engine.getHeight()))) {
+                restartAutopilotGame();
             }
             
             draw();
+            present();
+            profiler.endFrame();
+        }
+        save();
+        telemetry.close();
+        capture.close();
+        latency.report("snake");
+        turns.report("snake");
+        if (profiler.framesRecorded() > 0 && !profiler.writeCsv(profilePath.c_str())) {
+            fprintf(stderr, "cannot write profile to %s\n", profilePath.c_str());
         }
     }
 };
 
-int main() {
-    SnakeGame game;
+int main(int argc, char** argv) {
+    GameOptions options;
+    options.seed = chrono::high_resolution_clock::now().time_since_epoch().count();
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--profile" && i + 1 < argc) options.profilePath = argv[++i];
+        else if (arg == "--capture" && i + 1 < argc) options.capturePath = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc) options.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--autopilot") options.autopilot = true;
+        else if (arg == "--resume" && i + 1 < argc) options.resumePath = argv[++i];
+        else if (arg == "--telemetry" && i + 1 < argc) options.telemetryPath = argv[++i];
+        else if (arg == "--speed" && i + 1 < argc && atof(argv[i + 1]) >= MIN_SPEED && atof(argv[i + 1]) <= MAX_SPEED) {
+            options.moveSeconds = static_cast<float>(atof(argv[++i]));
+        }
+        else if (arg == "--capture-format" && i + 1 < argc && parseCaptureFormat(argv[i + 1], options.captureFormat)) ++i;
+        else if (arg == "--grid" && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%dx%d", &options.gridWidth, &options.gridHeight) == 2 &&
+                 options.gridWidth >= MIN_GRID && options.gridHeight >= MIN_GRID &&
+                 options.gridWidth <= MAX_GRID && options.gridHeight <= MAX_GRID) ++i;
+        else {
+            fprintf(stderr, "usage: %s [--seed N] [--grid WxH] [--autopilot] [--speed SECONDS] [--resume FILE] [--telemetry FILE] [--profile FILE] [--capture PATH [--capture-format ppm|rle]]\n", argv[0]);
+            return 1;
+        }
+    }
+    SnakeGame game(options);
     game.run();
     return 0;
 }
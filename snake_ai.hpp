@@ -0,0 +1,349 @@
+// Snake autopilot. Before each move it:
+//
+//   1. finds a shortest path to the food with A* over the free cells;
+//   2. plays the whole path on a copy of the occupancy and takes its first
+//      step only if the tail is still reachable from where the head ends
+//      up. Following the tail always leaves a way out.
+//   3. otherwise stalls: it takes the next step of a Hamiltonian cycle, or
+//      else any step, provided the tail stays reachable. With no safe step
+//      left it takes the one with the most room.
+//
+// The reachability test is a flood fill on a packed bitboard, 64 cells per
+// word. Rows are filled sideways in a few shift-and-mask steps and spread
+// up and down in alternating sweeps, so a fill costs a few passes over
+// width * height / 64 words. The cycle for the standard grid is built at
+// compile time.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "snake_engine.hpp"
+
+// Packed grid: one bit per cell, each row padded to whole 64-bit words
+class SnakeBitboard {
+public:
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        stride = (w + 63) / 64;
+        words.assign(static_cast<std::size_t>(stride) * h, 0);
+        edge = (w % 64) ? (std::uint64_t(1) << (w % 64)) - 1 : ~std::uint64_t(0);
+    }
+
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+    bool test(const Position& p) const { return (row(p.y)[p.x / 64] >> (p.x % 64)) & 1; }
+    void set(const Position& p) { row(p.y)[p.x / 64] |= std::uint64_t(1) << (p.x % 64); }
+    void reset(const Position& p) { row(p.y)[p.x / 64] &= ~(std::uint64_t(1) << (p.x % 64)); }
+
+    std::uint64_t* row(int y) { return &words[static_cast<std::size_t>(y) * stride]; }
+    const std::uint64_t* row(int y) const { return &words[static_cast<std::size_t>(y) * stride]; }
+
+    // Copies a row-major bit array with no row padding, as the engine keeps it
+    void load(const std::vector<std::uint64_t>& flat) {
+        for (int y = 0; y < height; ++y) {
+            std::uint64_t* out = row(y);
+            const std::size_t first = static_cast<std::size_t>(y) * width;
+            for (int i = 0; i < stride; ++i) {
+                const std::size_t bit = first + static_cast<std::size_t>(i) * 64;
+                const std::size_t word = bit / 64, shift = bit % 64;
+                std::uint64_t v = flat[word] >> shift;
+                if (shift && word + 1 < flat.size()) v |= flat[word + 1] << (64 - shift);
+                out[i] = v;
+            }
+            out[stride - 1] &= edge;
+        }
+    }
+
+    // Complement within the grid: set where this board is clear
+    void invert(const SnakeBitboard& from) {
+        for (std::size_t i = 0; i < words.size(); ++i) words[i] = ~from.words[i];
+        for (int y = 0; y < height; ++y) row(y)[stride - 1] &= edge;
+    }
+
+    int count() const {
+        int n = 0;
+        for (std::uint64_t w : words) n += __builtin_popcountll(w);
+        return n;
+    }
+
+    int width = 0, height = 0, stride = 0;
+    std::uint64_t edge = 0; // valid bits of each row's last word
+    std::vector<std::uint64_t> words;
+};
+
+// Grows `fill` to everything in `open` connected to it. Stops early once
+// `stopAt` is reached, if given. Returns whether `stopAt` was reached.
+inline bool floodFill(SnakeBitboard& fill, const SnakeBitboard& open, const Position* stopAt = nullptr) {
+    const int stride = fill.stride;
+    bool changed = true;
+    for (int sweep = 0; changed; ++sweep) {
+        changed = false;
+        const bool down = sweep % 2 == 0;
+        for (int i = 0; i < fill.height; ++i) {
+            const int y = down ? i : fill.height - 1 - i;
+            std::uint64_t* cur = fill.row(y);
+            const std::uint64_t* above = y > 0 ? fill.row(y - 1) : nullptr;
+            const std::uint64_t* below = y + 1 < fill.height ? fill.row(y + 1) : nullptr;
+            const std::uint64_t* mask = open.row(y);
+            bool any = sweep == 0; // the first sweep also spreads the seeds along their rows
+            // Seed from the rows above and below, then fill along the row
+            for (int w = 0; w < stride; ++w) {
+                std::uint64_t v = cur[w];
+                if (above) v |= above[w];
+                if (below) v |= below[w];
+                v &= mask[w];
+                any |= v != cur[w];
+                cur[w] = v;
+            }
+            if (!any) continue;
+            // Kogge-Stone fills inside each word towards higher bits, then
+            // lower bits, carrying into the neighbouring word between them
+            std::uint64_t carry = 0;
+            for (int w = 0; w < stride; ++w) {
+                std::uint64_t gen = cur[w] | (carry & mask[w]), pro = mask[w];
+                gen |= pro & (gen << 1); pro &= pro << 1;
+                gen |= pro & (gen << 2); pro &= pro << 2;
+                gen |= pro & (gen << 4); pro &= pro << 4;
+                gen |= pro & (gen << 8); pro &= pro << 8;
+                gen |= pro & (gen << 16); pro &= pro << 16;
+                gen |= pro & (gen << 32);
+                cur[w] = gen;
+                carry = gen >> 63;
+            }
+            carry = 0;
+            for (int w = stride - 1; w >= 0; --w) {
+                std::uint64_t gen = cur[w] | ((carry << 63) & mask[w]), pro = mask[w];
+                gen |= pro & (gen >> 1); pro &= pro >> 1;
+                gen |= pro & (gen >> 2); pro &= pro >> 2;
+                gen |= pro & (gen >> 4); pro &= pro >> 4;
+                gen |= pro & (gen >> 8); pro &= pro >> 8;
+                gen |= pro & (gen >> 16); pro &= pro >> 16;
+                gen |= pro & (gen >> 32);
+                cur[w] = gen;
+                carry = gen & 1;
+            }
+            changed = true;
+        }
+        if (stopAt && fill.test(*stopAt)) return true;
+    }
+    return stopAt && fill.test(*stopAt);
+}
+
+// Step directions along a Hamiltonian cycle of a Width x Height grid,
+// indexed by cell (y * Width + x)
+template <int Width, int Height>
+constexpr std::array<Direction, Width * Height> hamiltonianSuccessors() {
+    std::array<Direction, Width * Height> next{};
+    int firstX = -1, firstY = -1, lastX = 0, lastY = 0;
+    auto direction = [](int fromX, int fromY, int toX, int toY) {
+        if (toX > fromX) return RIGHT;
+        if (toX < fromX) return LEFT;
+        return toY > fromY ? DOWN : UP;
+    };
+    visitHamiltonianCycle(Width, Height, [&](int x, int y) {
+        if (firstX < 0) {
+            firstX = x;
+            firstY = y;
+        } else {
+            next[lastY * Width + lastX] = direction(lastX, lastY, x, y);
+        }
+        lastX = x;
+        lastY = y;
+    });
+    next[lastY * Width + lastX] = direction(lastX, lastY, firstX, firstY);
+    return next;
+}
+
+static_assert(GRID_WIDTH % 2 == 0, "the standard cycle needs an even grid width");
+constexpr std::array<Direction, GRID_WIDTH * GRID_HEIGHT> STANDARD_CYCLE =
+    hamiltonianSuccessors<GRID_WIDTH, GRID_HEIGHT>();
+
+// Late in a game the body can close into a loop that the head follows
+// forever, walling the food off for good. Soak runs give up on a game after
+// this many moves without eating.
+inline long autopilotStallLimit(int width, int height) { return 4L * width * height; }
+
+class SnakeAutopilot {
+public:
+    SnakeAutopilot(int width = GRID_WIDTH, int height = GRID_HEIGHT) : width(width), height(height) {
+        const std::size_t cells = static_cast<std::size_t>(width) * height;
+        occupied.resize(width, height);
+        virtualBody.resize(width, height);
+        open.resize(width, height);
+        fill.resize(width, height);
+        seenAt.assign(cells, 0);
+        cost.assign(cells, 0);
+        cameFrom.assign(cells, NONE);
+        buildCycle();
+    }
+
+    // Direction for the next move of `game`
+    Direction decide(const SnakeEngine& game) {
+        const SnakeBody& snake = game.getBody();
+        const Position head = snake.front();
+        occupied.load(game.getOccupancy());
+
+        if (game.hasFood() && findPath(head, game.getFood())) {
+            if (tailReachableAfter(snake, path, true)) return towards(head, path.front());
+        }
+
+        // No safe way to the food: stall along the cycle, or any safe step,
+        // until the body has moved out of the way
+        Direction fallback = NONE;
+        int fallbackRoom = -1;
+        for (Direction d : {cycleStep(head), UP, DOWN, LEFT, RIGHT}) {
+            if (d == NONE) continue;
+            const Position next = step(head, d);
+            if (!isOpen(next)) continue;
+            path.assign(1, next);
+            if (tailReachableAfter(snake, path, game.hasFood() && next == game.getFood())) return d;
+            const int room = fill.count();
+            if (room > fallbackRoom) {
+                fallback = d;
+                fallbackRoom = room;
+            }
+        }
+        return fallback;
+    }
+
+private:
+    int width;
+    int height;
+    SnakeBitboard occupied, virtualBody, open, fill;
+    // A* scratch, reused across decisions; seenAt marks cells touched by the
+    // current search so nothing needs clearing between searches
+    std::vector<std::uint32_t> seenAt;
+    std::vector<int> cost;
+    std::vector<std::uint8_t> cameFrom;   // Direction each cell was entered by
+    std::vector<std::vector<int>> buckets;
+    std::uint32_t search = 0;
+    std::vector<Position> path;           // head excluded, target last
+    const Direction* cycle = nullptr;     // successor per cell, or null
+    std::vector<Direction> runtimeCycle;  // for grids other than the standard one
+
+    static Position step(const Position& p, Direction d) {
+        switch (d) {
+            case UP: return Position(p.x, p.y - 1);
+            case DOWN: return Position(p.x, p.y + 1);
+            case LEFT: return Position(p.x - 1, p.y);
+            case RIGHT: return Position(p.x + 1, p.y);
+            default: return p;
+        }
+    }
+
+    bool inside(const Position& p) const { return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height; }
+    bool isOpen(const Position& p) const { return inside(p) && !occupied.test(p); }
+    std::size_t index(const Position& p) const { return static_cast<std::size_t>(p.y) * width + p.x; }
+
+    Direction cycleStep(const Position& p) const { return cycle ? cycle[index(p)] : NONE; }
+
+    // The standard grid uses the compile-time table. Other grids need an
+    // even side; the cycle is laid out along it, transposed if that is the
+    // height. A grid with both sides odd has no Hamiltonian cycle.
+    void buildCycle() {
+        if (width == GRID_WIDTH && height == GRID_HEIGHT) {
+            cycle = STANDARD_CYCLE.data();
+            return;
+        }
+        const bool transpose = width % 2 != 0;
+        if (transpose && height % 2 != 0) return;
+        const std::vector<Position> order = transpose ? hamiltonianCycle(height, width) : hamiltonianCycle(width, height);
+        runtimeCycle.assign(order.size(), NONE);
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            Position from = order[i], to = order[(i + 1) % order.size()];
+            if (transpose) {
+                from = Position(from.y, from.x);
+                to = Position(to.y, to.x);
+            }
+            runtimeCycle[index(from)] = towards(from, to);
+        }
+        cycle = runtimeCycle.data();
+    }
+
+    // A* with a Manhattan heuristic over cells free of the snake. Buckets
+    // are indexed by estimated total length; within one, the latest cell
+    // comes out first, which favours paths already far along. Fills `path`.
+    bool findPath(const Position& from, const Position& to) {
+        if (++search == 0) {
+            std::fill(seenAt.begin(), seenAt.end(), 0);
+            search = 1;
+        }
+        auto estimate = [&](const Position& p) { return std::abs(p.x - to.x) + std::abs(p.y - to.y); };
+        const int base = estimate(from);
+        for (auto& b : buckets) b.clear();
+        auto push = [&](const Position& p, int g) {
+            const std::size_t f = static_cast<std::size_t>(g + estimate(p) - base);
+            if (f >= buckets.size()) buckets.resize(f + 1);
+            buckets[f].push_back(static_cast<int>(index(p)));
+        };
+        seenAt[index(from)] = search;
+        cost[index(from)] = 0;
+        push(from, 0);
+        for (std::size_t f = 0; f < buckets.size(); ++f) {
+            while (!buckets[f].empty()) {
+                const int cell = buckets[f].back();
+                buckets[f].pop_back();
+                const Position p(cell % width, cell / width);
+                const int g = cost[cell];
+                if (static_cast<std::size_t>(g + estimate(p) - base) != f) continue; // stale entry
+                if (p == to) {
+                    path.clear();
+                    for (Position at = to; !(at == from);
+                         at = step(at, SnakeEngine::opposite(static_cast<Direction>(cameFrom[index(at)])))) {
+                        path.push_back(at);
+                    }
+                    std::reverse(path.begin(), path.end());
+                    return true;
+                }
+                for (Direction d : {UP, DOWN, LEFT, RIGHT}) {
+                    const Position n = step(p, d);
+                    if (!isOpen(n)) continue;
+                    const std::size_t i = index(n);
+                    if (seenAt[i] == search && cost[i] <= g + 1) continue;
+                    seenAt[i] = search;
+                    cost[i] = g + 1;
+                    cameFrom[i] = static_cast<std::uint8_t>(d);
+                    push(n, g + 1);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Plays `steps` (the last one eating if `eats`) on a copy of the body,
+    // then flood-fills from the new head. Leaves the fill in `fill`.
+    bool tailReachableAfter(const SnakeBody& snake, const std::vector<Position>& steps, bool eats) {
+        const std::size_t n = snake.size();
+        const std::size_t moves = steps.size();
+        const std::size_t length = n + (eats ? 1 : 0);
+        virtualBody.words = occupied.words;
+        // Segments still in the body after the moves: the last `length`
+        // cells of steps (newest first) followed by the old body
+        const std::size_t fromSteps = std::min(moves, length);
+        const std::size_t fromBody = length - fromSteps;
+        for (std::size_t i = fromBody; i < n; ++i) virtualBody.reset(snake[i]);
+        for (std::size_t i = moves - fromSteps; i < moves; ++i) virtualBody.set(steps[i]);
+        const Position head = steps.back();
+        const Position tail = fromBody > 0 ? snake[fromBody - 1] : steps[moves - length];
+
+        // The engine checks for collisions before the tail moves, so the
+        // head may only follow the tail with at least one free cell between
+        // them. The fill starts from the free cells next to the head.
+        open.invert(virtualBody);
+        open.set(tail);
+        fill.clear();
+        bool seeded = false;
+        for (Direction d : {UP, DOWN, LEFT, RIGHT}) {
+            const Position n = step(head, d);
+            if (inside(n) && !virtualBody.test(n)) {
+                fill.set(n);
+                seeded = true;
+            }
+        }
+        return seeded && floodFill(fill, open, &tail);
+    }
+};
@@ -0,0 +1,395 @@
+// Many AI snakes and many food items on one large grid, for load-testing
+// bots. A tick runs in three phases:
+//
+//   decide   (parallel) every live snake picks its next cell from the state
+//            at the start of the tick. Snakes are grouped by the band of
+//            rows their head is in, and each band is one task.
+//   resolve  (parallel) each band takes the claims on cells in its rows,
+//            settles contested cells and applies the winning moves. Every
+//            claim belongs to exactly one band, and the cells written
+//            (free cells entered, tails left, dead bodies cleared) never
+//            overlap between bands, so no locks are needed.
+//   merge    (serial) eaten food is replaced and dead snakes respawn.
+//
+// Rules: a snake dies when its next cell is a wall or any segment,
+// including a tail that is about to move. Tails count as occupied, which
+// keeps every decision independent of the others. Two heads swapping
+// cells therefore both die. When several snakes enter the same free cell,
+// the longest gets it and the rest die. If the longest are tied, all of
+// them die.
+//
+// Every random choice comes from a per-snake or per-arena xoshiro stream,
+// and claims are sorted before they are settled. Results therefore depend
+// only on the seed, not on the thread count.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "snake_engine.hpp"
+#include "thread_pool.hpp"
+#include "xoshiro.hpp"
+
+const int ARENA_BAND_ROWS = 8;
+const int ARENA_SPAWN_LENGTH = 3;
+const int ARENA_SPAWN_ATTEMPTS = 64;
+// Free cells a bot looks for past each candidate move before calling it safe
+const int ARENA_LOOKAHEAD = 48;
+
+struct ArenaOptions {
+    int width = 1024;
+    int height = 1024;
+    int snakes = 500;
+    int food = 2000;        // food kept on the grid
+    unsigned threads = 0;   // 0 = one per core
+    std::uint64_t seed = 1;
+};
+
+struct ArenaSnake {
+    SnakeBody body;
+    Direction dir = RIGHT;
+    Position target;        // food the bot is heading for
+    Xoshiro256ss rng;
+    bool alive = false;
+    int score = 0;
+};
+
+struct ArenaTickStats {
+    int moves = 0;          // snakes that moved this tick
+    int deaths = 0;
+    int eaten = 0;
+};
+
+class SnakeArena {
+public:
+    explicit SnakeArena(const ArenaOptions& options)
+        : width(options.width), height(options.height), foodTarget(options.food), rng(options.seed),
+          pool(options.threads), cells(static_cast<std::size_t>(width) * height, EMPTY),
+          bands((height + ARENA_BAND_ROWS - 1) / ARENA_BAND_ROWS), scratch(pool.size()) {
+        Xoshiro256ss streams(options.seed);
+        snakes.resize(options.snakes);
+        for (ArenaSnake& s : snakes) {
+            streams.jump();
+            s.rng = streams;
+            s.body.reset();
+        }
+        for (int id = 0; id < options.snakes; ++id) respawning.push_back(id);
+        refillFood();
+        respawn();
+    }
+
+    ArenaTickStats tick() {
+        pool.parallelFor(bands.size(), [this](std::size_t b, unsigned worker) { decideBand(b, worker); });
+        pool.parallelFor(bands.size(), [this](std::size_t b, unsigned) { resolveBand(b); });
+        return merge();
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    unsigned threads() const { return pool.size(); }
+    const std::vector<ArenaSnake>& getSnakes() const { return snakes; }
+    const std::vector<Position>& getFood() const { return food; }
+    std::uint64_t getTicks() const { return ticks; }
+
+    int aliveCount() const {
+        int n = 0;
+        for (const ArenaSnake& s : snakes) n += s.alive;
+        return n;
+    }
+
+    // FNV-1a over every snake's cells and score and every food cell. Runs
+    // from the same seed give the same value at any thread count.
+    std::uint64_t checksum() const {
+        std::uint64_t h = 0xCBF29CE484222325ull;
+        auto mix = [&h](std::uint64_t v) {
+            h ^= v;
+            h *= 0x100000001B3ull;
+        };
+        for (const ArenaSnake& s : snakes) {
+            mix(s.alive);
+            mix(static_cast<std::uint64_t>(s.score));
+            for (std::size_t i = 0; i < s.body.size(); ++i) mix(cellIndex(s.body[i]));
+        }
+        for (const Position& p : food) mix(cellIndex(p));
+        return h;
+    }
+
+private:
+    // Cell contents: a snake id, EMPTY, or food in slot k stored as FOOD - k
+    static constexpr std::int32_t EMPTY = -1;
+    static constexpr std::int32_t FOOD = -2;
+
+    struct Claim {
+        std::uint32_t cell;
+        std::int32_t id;
+        bool operator<(const Claim& o) const { return cell != o.cell ? cell < o.cell : id < o.id; }
+    };
+
+    struct Band {
+        std::vector<int> members;           // live snakes whose head is in the band
+        std::vector<int> nextMembers;
+        std::vector<Claim> outbox[3];       // claims on the band above, this one and the one below
+        std::vector<Claim> claims;
+        std::vector<int> dead;
+        std::vector<std::int32_t> eaten;    // food slots
+        int moves = 0;
+    };
+
+    // Visited stamps for the lookahead, over a window centred on the head
+    struct Scratch {
+        static constexpr int SIDE = 2 * ARENA_LOOKAHEAD + 1;
+        std::vector<std::uint32_t> seen = std::vector<std::uint32_t>(SIDE * SIDE, 0);
+        std::uint32_t stamp = 0;
+        std::vector<Position> queue;
+    };
+
+    int width;
+    int height;
+    int foodTarget;
+    Xoshiro256ss rng;
+    TaskPool pool;
+    std::vector<std::int32_t> cells;
+    std::vector<ArenaSnake> snakes;
+    std::vector<Position> food;
+    std::vector<Band> bands;
+    std::vector<Scratch> scratch;           // one per pool worker
+    std::vector<int> respawning;            // dead snakes waiting for a free spot, by id
+    std::uint64_t ticks = 0;
+
+    std::uint32_t cellIndex(const Position& p) const { return static_cast<std::uint32_t>(p.y) * width + p.x; }
+    bool inside(const Position& p) const { return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height; }
+    bool isFree(const Position& p) const { return inside(p) && cells[cellIndex(p)] < 0; }
+
+    static Position step(const Position& p, Direction d) {
+        switch (d) {
+            case UP: return Position(p.x, p.y - 1);
+            case DOWN: return Position(p.x, p.y + 1);
+            case LEFT: return Position(p.x - 1, p.y);
+            case RIGHT: return Position(p.x + 1, p.y);
+            default: return p;
+        }
+    }
+
+    static bool opposite(Direction a, Direction b) {
+        return (a == UP && b == DOWN) || (a == DOWN && b == UP) || (a == LEFT && b == RIGHT) ||
+               (a == RIGHT && b == LEFT);
+    }
+
+    // Free cells reachable from `from`, counted up to ARENA_LOOKAHEAD
+    int reach(const Position& from, Scratch& s) const {
+        if (++s.stamp == 0) {
+            std::fill(s.seen.begin(), s.seen.end(), 0);
+            s.stamp = 1;
+        }
+        auto mark = [&](const Position& p) {
+            std::uint32_t& seen = s.seen[(p.y - from.y + ARENA_LOOKAHEAD) * Scratch::SIDE + (p.x - from.x + ARENA_LOOKAHEAD)];
+            if (seen == s.stamp) return false;
+            seen = s.stamp;
+            return true;
+        };
+        s.queue.clear();
+        s.queue.push_back(from);
+        mark(from);
+        for (std::size_t i = 0; i < s.queue.size() && static_cast<int>(s.queue.size()) < ARENA_LOOKAHEAD; ++i) {
+            for (Direction d : {UP, DOWN, LEFT, RIGHT}) {
+                const Position n = step(s.queue[i], d);
+                if (isFree(n) && mark(n)) s.queue.push_back(n);
+            }
+        }
+        return static_cast<int>(std::min<std::size_t>(s.queue.size(), ARENA_LOOKAHEAD));
+    }
+
+    // Nearest of a few randomly sampled food items
+    Position pickTarget(ArenaSnake& s) const {
+        const Position& head = s.body.front();
+        Position best = head;
+        int bestDistance = -1;
+        for (int i = 0; i < 4 && !food.empty(); ++i) {
+            const Position& f = food[s.rng.below(static_cast<std::uint32_t>(food.size()))];
+            const int d = std::abs(f.x - head.x) + std::abs(f.y - head.y);
+            if (bestDistance < 0 || d < bestDistance) {
+                best = f;
+                bestDistance = d;
+            }
+        }
+        return best;
+    }
+
+    // Prefers moves with room behind them, then moves towards the target
+    void decide(ArenaSnake& s, Scratch& scratch) const {
+        if (!inside(s.target) || cells[cellIndex(s.target)] > FOOD) s.target = pickTarget(s);
+        const Position& head = s.body.front();
+        Direction best = s.dir;
+        long bestScore = 0;
+        bool found = false;
+        for (Direction d : {UP, DOWN, LEFT, RIGHT}) {
+            if (opposite(d, s.dir)) continue;
+            const Position next = step(head, d);
+            if (!isFree(next)) continue;
+            const int distance = std::abs(s.target.x - next.x) + std::abs(s.target.y - next.y);
+            const long score = static_cast<long>(reach(next, scratch)) * 1000000 - distance * 4 +
+                               static_cast<long>(s.rng.below(4));
+            if (!found || score > bestScore) {
+                best = d;
+                bestScore = score;
+                found = true;
+            }
+        }
+        s.dir = best;
+    }
+
+    void decideBand(std::size_t b, unsigned worker) {
+        Band& band = bands[b];
+        for (auto& out : band.outbox) out.clear();
+        band.dead.clear();
+        for (int id : band.members) {
+            ArenaSnake& s = snakes[id];
+            decide(s, scratch[worker]);
+            const Position next = step(s.body.front(), s.dir);
+            if (!isFree(next)) {
+                band.dead.push_back(id);
+                continue;
+            }
+            const int to = next.y / ARENA_BAND_ROWS - static_cast<int>(b) + 1;
+            band.outbox[to].push_back(Claim{cellIndex(next), id});
+        }
+    }
+
+    void resolveBand(std::size_t b) {
+        Band& band = bands[b];
+        band.claims.assign(band.outbox[1].begin(), band.outbox[1].end());
+        if (b > 0) band.claims.insert(band.claims.end(), bands[b - 1].outbox[2].begin(), bands[b - 1].outbox[2].end());
+        if (b + 1 < bands.size()) {
+            band.claims.insert(band.claims.end(), bands[b + 1].outbox[0].begin(), bands[b + 1].outbox[0].end());
+        }
+        std::sort(band.claims.begin(), band.claims.end());
+        band.nextMembers.clear();
+        band.eaten.clear();
+        band.moves = 0;
+
+        for (std::size_t i = 0; i < band.claims.size();) {
+            std::size_t end = i + 1;
+            while (end < band.claims.size() && band.claims[end].cell == band.claims[i].cell) ++end;
+            // Longest contender wins; a tie for longest kills them all
+            std::size_t longest = 0;
+            int winners = 0, winner = -1;
+            for (std::size_t k = i; k < end; ++k) {
+                const std::size_t length = snakes[band.claims[k].id].body.size();
+                if (length > longest) {
+                    longest = length;
+                    winners = 0;
+                }
+                if (length == longest) {
+                    ++winners;
+                    winner = band.claims[k].id;
+                }
+            }
+            if (winners > 1) winner = -1;
+            for (std::size_t k = i; k < end; ++k) {
+                if (band.claims[k].id != winner) band.dead.push_back(band.claims[k].id);
+            }
+            if (winner >= 0) move(band, winner, band.claims[i].cell);
+            i = end;
+        }
+        for (int id : band.dead) kill(id);
+    }
+
+    void move(Band& band, int id, std::uint32_t cell) {
+        ArenaSnake& s = snakes[id];
+        const std::int32_t was = cells[cell];
+        s.body.pushFront(Position(static_cast<int>(cell % width), static_cast<int>(cell / width)));
+        cells[cell] = id;
+        if (was <= FOOD) {
+            band.eaten.push_back(FOOD - was);
+            ++s.score;
+        } else {
+            cells[cellIndex(s.body.back())] = EMPTY;
+            s.body.popBack();
+        }
+        band.nextMembers.push_back(id);
+        ++band.moves;
+    }
+
+    void kill(int id) {
+        ArenaSnake& s = snakes[id];
+        for (std::size_t i = 0; i < s.body.size(); ++i) cells[cellIndex(s.body[i])] = EMPTY;
+        s.body.reset();
+        s.alive = false;
+    }
+
+    ArenaTickStats merge() {
+        ArenaTickStats stats;
+        std::vector<std::int32_t> eaten;
+        for (Band& band : bands) {
+            stats.moves += band.moves;
+            stats.deaths += static_cast<int>(band.dead.size());
+            eaten.insert(eaten.end(), band.eaten.begin(), band.eaten.end());
+            respawning.insert(respawning.end(), band.dead.begin(), band.dead.end());
+            band.members.swap(band.nextMembers);
+        }
+        stats.eaten = static_cast<int>(eaten.size());
+        // Remove from the highest slot down, so the entry swapped into a
+        // freed slot is never one that was eaten too
+        std::sort(eaten.begin(), eaten.end(), [](std::int32_t a, std::int32_t b) { return a > b; });
+        for (std::int32_t slot : eaten) {
+            food[slot] = food.back();
+            food.pop_back();
+            if (static_cast<std::size_t>(slot) < food.size()) cells[cellIndex(food[slot])] = FOOD - slot;
+        }
+        std::sort(respawning.begin(), respawning.end());
+        refillFood();
+        respawn();
+        ++ticks;
+        return stats;
+    }
+
+    // Tops food up to the target on random free cells. Gives up on a cell
+    // after a few misses, so a crowded grid just runs short of food.
+    void refillFood() {
+        for (int missing = foodTarget - static_cast<int>(food.size()); missing > 0; --missing) {
+            for (int attempt = 0; attempt < ARENA_SPAWN_ATTEMPTS; ++attempt) {
+                const Position p(static_cast<int>(rng.below(width)), static_cast<int>(rng.below(height)));
+                if (cells[cellIndex(p)] != EMPTY) continue;
+                cells[cellIndex(p)] = FOOD - static_cast<std::int32_t>(food.size());
+                food.push_back(p);
+                break;
+            }
+        }
+    }
+
+    // Dead snakes come back as a short horizontal snake heading right, on
+    // random free cells. Those that find no room wait for the next tick.
+    void respawn() {
+        std::size_t waiting = 0;
+        for (int id : respawning) {
+            if (!spawn(id)) respawning[waiting++] = id;
+        }
+        respawning.resize(waiting);
+    }
+
+    bool spawn(int id) {
+        const int length = ARENA_SPAWN_LENGTH;
+        if (width < length + 1) return false;
+        for (int attempt = 0; attempt < ARENA_SPAWN_ATTEMPTS; ++attempt) {
+            const int x = length - 1 + static_cast<int>(rng.below(width - length));
+            const int y = static_cast<int>(rng.below(height));
+            bool room = true;
+            for (int i = -1; i < length && room; ++i) room = cells[cellIndex(Position(x - i, y))] == EMPTY;
+            if (!room) continue;
+            ArenaSnake& s = snakes[id];
+            s.body.reset();
+            for (int i = 0; i < length; ++i) {
+                s.body.pushBack(Position(x - i, y));
+                cells[cellIndex(Position(x - i, y))] = id;
+            }
+            s.dir = RIGHT;
+            s.target = Position(-1, -1);
+            s.alive = true;
+            bands[y / ARENA_BAND_ROWS].members.push_back(id);
+            return true;
+        }
+        return false;
+    }
+};
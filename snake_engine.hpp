@@ -0,0 +1,389 @@
+// Snake rules without SFML: grid, snake, food and score. The game moves it
+// at a fixed rate; benchmarks and tools can drive it directly.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "xoshiro.hpp"
+
+const int GRID_WIDTH = 20;
+const int GRID_HEIGHT = 20;
+
+enum Direction { UP, DOWN, LEFT, RIGHT, NONE };
+
+struct Position {
+    int x, y;
+    Position(int x = 0, int y = 0) : x(x), y(y) {}
+    bool operator==(const Position& other) const {
+        return x == other.x && y == other.y;
+    }
+};
+
+// Fixed-width head of a snake snapshot. It is followed by width * height
+// cell indices (y * width + x): the body, head first, then the free cells in
+// the order food placement draws from them. That order is part of the game,
+// so a restored game places the same food as the original would have.
+struct SnakeSnapshotHeader {
+    std::uint32_t width, height, length;
+    std::int32_t foodX, foodY, previousTailX, previousTailY;
+    std::uint32_t score;
+    std::uint8_t dir, nextDir, gameOver, moved, grew, unused[3];
+    std::uint64_t rng[4];
+};
+static_assert(sizeof(SnakeSnapshotHeader) == 72, "snapshot layout is fixed");
+
+// Snake segments, head first, in a ring buffer. Moving writes the new head
+// in front of the old one and drops the tail by shortening the ring, so
+// nothing is shifted. The ring doubles when the snake outgrows it.
+class SnakeBody {
+public:
+    void reset() {
+        cells.assign(16, Position());
+        head = 0;
+        count = 0;
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // i-th segment from the head
+    const Position& operator[](std::size_t i) const { return cells[wrap(head + i)]; }
+    const Position& front() const { return cells[head]; }
+    const Position& back() const { return (*this)[count - 1]; }
+
+    void pushFront(const Position& p) {
+        if (count == cells.size()) grow();
+        head = head == 0 ? cells.size() - 1 : head - 1;
+        cells[head] = p;
+        ++count;
+    }
+    void pushBack(const Position& p) {
+        if (count == cells.size()) grow();
+        cells[wrap(head + count)] = p;
+        ++count;
+    }
+    void popBack() { --count; }
+
+private:
+    std::vector<Position> cells;
+    std::size_t head = 0;
+    std::size_t count = 0;
+
+    std::size_t wrap(std::size_t i) const { return i >= cells.size() ? i - cells.size() : i; }
+
+    void grow() {
+        std::vector<Position> bigger(cells.size() * 2);
+        for (std::size_t i = 0; i < count; ++i) bigger[i] = (*this)[i];
+        cells.swap(bigger);
+        head = 0;
+    }
+};
+
+class SnakeEngine {
+public:
+    // The seed picks where food appears; the same seed and moves replay the same game
+    SnakeEngine(int width = GRID_WIDTH, int height = GRID_HEIGHT, std::uint64_t seed = 0)
+        : width(width), height(height), rng(seed) { reset(); }
+
+    void reset() {
+        // Initialize snake in the center
+        clearBody();
+        addSegment(Position(width / 2, height / 2));
+        addSegment(Position(width / 2 - 1, height / 2));
+        addSegment(Position(width / 2 - 2, height / 2));
+        dir = RIGHT;
+        nextDir = NONE;
+        gameOver = false;
+        score = 0;
+        moved = false;
+        grew = false;
+        previousTail = snake.back();
+        generateFood();
+    }
+
+    // Queues a turn for the next move. Turning straight back is refused.
+    bool steer(Direction d) {
+        if (d == NONE || d == opposite(dir)) return false;
+        nextDir = d;
+        return true;
+    }
+
+    void moveSnake() {
+        if (nextDir != NONE) {
+            dir = nextDir;
+            nextDir = NONE;
+        }
+
+        Position head = snake.front();
+
+        switch (dir) {
+            case UP:
+                head.y--;
+                break;
+            case DOWN:
+                head.y++;
+                break;
+            case LEFT:
+                head.x--;
+                break;
+            case RIGHT:
+                head.x++;
+                break;
+            default:
+                return;
+        }
+
+        // Check wall collision
+        if (head.x < 0 || head.x >= width || head.y < 0 || head.y >= height) {
+            gameOver = true;
+            return;
+        }
+
+        // Check self collision
+        if (isSnakePosition(head)) {
+            gameOver = true;
+            return;
+        }
+
+        snake.pushFront(head);
+        setOccupied(head, true);
+        moved = true;
+        previousTail = snake.back();
+
+        // Check food collision
+        grew = head == food;
+        if (grew) {
+            score++;
+            generateFood();
+        } else {
+            setOccupied(snake.back(), false);
+            snake.popBack();
+        }
+    }
+
+    bool isSnakePosition(const Position& pos) const {
+        if (pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= height) return false;
+        const std::size_t i = cellIndex(pos);
+        return (occupied[i / 64] >> (i % 64)) & 1;
+    }
+
+    // Puts food on a uniformly chosen free cell, in constant time. With no
+    // free cell left there is no food.
+    void generateFood() {
+        if (freeCells.empty()) {
+            food = Position(-1, -1);
+            return;
+        }
+        const int cell = freeCells[rng.below(static_cast<std::uint32_t>(freeCells.size()))];
+        food = Position(cell % width, cell / width);
+    }
+
+    // Puts the snake in an arbitrary position, head first
+    void setSnake(const std::vector<Position>& body, Direction heading) {
+        clearBody();
+        for (const Position& p : body) addSegment(p);
+        dir = heading;
+        nextDir = NONE;
+        gameOver = false;
+        moved = false;
+        grew = false;
+        previousTail = snake.back();
+    }
+
+    void setFood(const Position& pos) { food = pos; }
+
+    // Cell indices that follow a SnakeSnapshotHeader: one per grid cell
+    std::size_t snapshotCells() const { return static_cast<std::size_t>(width) * height; }
+
+    void saveSnapshot(SnakeSnapshotHeader& header, std::uint32_t* cells) const {
+        header = SnakeSnapshotHeader{};
+        header.width = static_cast<std::uint32_t>(width);
+        header.height = static_cast<std::uint32_t>(height);
+        header.length = static_cast<std::uint32_t>(snake.size());
+        header.foodX = food.x;
+        header.foodY = food.y;
+        header.previousTailX = previousTail.x;
+        header.previousTailY = previousTail.y;
+        header.score = static_cast<std::uint32_t>(score);
+        header.dir = static_cast<std::uint8_t>(dir);
+        header.nextDir = static_cast<std::uint8_t>(nextDir);
+        header.gameOver = gameOver;
+        header.moved = moved;
+        header.grew = grew;
+        rng.getState(header.rng);
+        for (std::size_t i = 0; i < snake.size(); ++i) cells[i] = static_cast<std::uint32_t>(cellIndex(snake[i]));
+        for (std::size_t i = 0; i < freeCells.size(); ++i) cells[snake.size() + i] = static_cast<std::uint32_t>(freeCells[i]);
+    }
+
+    // Resumes a game from saveSnapshot() on a grid of the same size. Refuses,
+    // leaving this game unchanged, anything no game could have produced: the
+    // cells must list every cell once and the body must be connected.
+    bool restoreSnapshot(const SnakeSnapshotHeader& header, const std::uint32_t* cells) {
+        const std::size_t total = snapshotCells();
+        if (header.width != static_cast<std::uint32_t>(width) || header.height != static_cast<std::uint32_t>(height) ||
+            header.length == 0 || header.length > total || header.dir > RIGHT || header.nextDir > NONE) {
+            return false;
+        }
+        const Position restoredFood(header.foodX, header.foodY);
+        const Position restoredTail(header.previousTailX, header.previousTailY);
+        if (!inGrid(restoredTail) || (!inGrid(restoredFood) && !(header.foodX == -1 && header.foodY == -1))) return false;
+        Xoshiro256ss restoredRng;
+        if (!restoredRng.setState(header.rng)) return false;
+
+        // Food lies on a free cell; foodCell is out of range when there is none
+        const std::size_t foodCell = inGrid(restoredFood) ? cellIndex(restoredFood) : total;
+        std::vector<std::uint64_t> seen((total + 63) / 64, 0);
+        for (std::size_t i = 0; i < total; ++i) {
+            const std::uint32_t c = cells[i];
+            if (c >= total || ((seen[c / 64] >> (c % 64)) & 1) || (i < header.length && c == foodCell)) return false;
+            seen[c / 64] |= std::uint64_t(1) << (c % 64);
+            if (i > 0 && i < header.length) {
+                const int dx = static_cast<int>(c % width) - static_cast<int>(cells[i - 1] % width);
+                const int dy = static_cast<int>(c / width) - static_cast<int>(cells[i - 1] / width);
+                if (dx * dx + dy * dy != 1) return false;
+            }
+        }
+
+        snake.reset();
+        occupied.assign(seen.size(), 0);
+        freeCells.assign(cells + header.length, cells + total);
+        freeSlot.assign(total, -1);
+        for (std::size_t i = 0; i < header.length; ++i) {
+            const Position p(static_cast<int>(cells[i] % width), static_cast<int>(cells[i] / width));
+            snake.pushBack(p);
+            occupied[cells[i] / 64] |= std::uint64_t(1) << (cells[i] % 64);
+        }
+        for (std::size_t i = 0; i < freeCells.size(); ++i) freeSlot[freeCells[i]] = static_cast<int>(i);
+        rng = restoredRng;
+        food = restoredFood;
+        previousTail = restoredTail;
+        dir = static_cast<Direction>(header.dir);
+        nextDir = static_cast<Direction>(header.nextDir);
+        gameOver = header.gameOver != 0;
+        score = static_cast<int>(header.score);
+        moved = header.moved != 0;
+        grew = header.grew != 0;
+        return true;
+    }
+
+    const SnakeBody& getBody() const { return snake; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const Position& getFood() const { return food; }
+    bool hasFood() const { return food.x >= 0; }
+    int freeCellCount() const { return static_cast<int>(freeCells.size()); }
+    // One bit per cell, row-major (bit y * width + x), set where a segment is
+    const std::vector<std::uint64_t>& getOccupancy() const { return occupied; }
+    Direction getDirection() const { return dir; }
+    bool hasQueuedTurn() const { return nextDir != NONE; }
+    bool isGameOver() const { return gameOver; }
+    int getScore() const { return score; }
+    bool hasMoved() const { return moved; }
+    // Whether the last move ate food, so the tail stayed where it was
+    bool ateFood() const { return grew; }
+    // Tail cell before the last move
+    const Position& getPreviousTail() const { return previousTail; }
+
+    static Direction opposite(Direction d) {
+        switch (d) {
+            case UP: return DOWN;
+            case DOWN: return UP;
+            case LEFT: return RIGHT;
+            case RIGHT: return LEFT;
+            default: return NONE;
+        }
+    }
+
+private:
+    int width;
+    int height;
+    SnakeBody snake;
+    // One bit per grid cell, set where a segment is
+    std::vector<std::uint64_t> occupied;
+    // Cells without a segment, in no particular order, and where each cell
+    // sits in freeCells (-1 while occupied). Removal swaps in the last entry.
+    std::vector<int> freeCells;
+    std::vector<int> freeSlot;
+    Xoshiro256ss rng;
+    Position food;
+    Direction dir;
+    Direction nextDir;
+    bool gameOver;
+    int score;
+    bool moved;
+    bool grew;
+    Position previousTail;
+
+    bool inGrid(const Position& p) const { return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height; }
+
+    std::size_t cellIndex(const Position& p) const {
+        return static_cast<std::size_t>(p.y) * width + p.x;
+    }
+
+    void setOccupied(const Position& p, bool on) {
+        const std::size_t i = cellIndex(p);
+        const std::uint64_t bit = std::uint64_t(1) << (i % 64);
+        if (on) {
+            occupied[i / 64] |= bit;
+            const int slot = freeSlot[i];
+            const int last = freeCells.back();
+            freeCells[slot] = last;
+            freeSlot[last] = slot;
+            freeCells.pop_back();
+            freeSlot[i] = -1;
+        } else {
+            occupied[i / 64] &= ~bit;
+            freeSlot[i] = static_cast<int>(freeCells.size());
+            freeCells.push_back(static_cast<int>(i));
+        }
+    }
+
+    void clearBody() {
+        const std::size_t cells = static_cast<std::size_t>(width) * height;
+        snake.reset();
+        occupied.assign((cells + 63) / 64, 0);
+        freeCells.resize(cells);
+        freeSlot.resize(cells);
+        for (std::size_t i = 0; i < cells; ++i) {
+            freeCells[i] = static_cast<int>(i);
+            freeSlot[i] = static_cast<int>(i);
+        }
+    }
+
+    void addSegment(const Position& p) {
+        snake.pushBack(p);
+        if (!isSnakePosition(p)) setOccupied(p, true);
+    }
+};
+
+// Visits a cycle through every cell of a width x height grid (width even),
+// calling visit(x, y) in order: down the first column, up and down the
+// rest, then back along the top row. constexpr, so fixed grids can build
+// tables from it at compile time.
+template <typename Visit>
+constexpr void visitHamiltonianCycle(int width, int height, Visit&& visit) {
+    for (int y = 0; y < height; ++y) visit(0, y);
+    for (int x = 1; x < width; ++x) {
+        if (x % 2) {
+            for (int y = height - 1; y >= 1; --y) visit(x, y);
+        } else {
+            for (int y = 1; y < height; ++y) visit(x, y);
+        }
+    }
+    for (int x = width - 1; x >= 1; --x) visit(x, 0);
+}
+
+// The same cycle as a list. Benchmarks and soak tests steer along it to
+// keep a snake alive forever.
+inline std::vector<Position> hamiltonianCycle(int width, int height) {
+    std::vector<Position> cycle;
+    visitHamiltonianCycle(width, height, [&](int x, int y) { cycle.push_back(Position(x, y)); });
+    return cycle;
+}
+
+// Direction of the step from one cell to a neighbouring one
+inline Direction towards(const Position& from, const Position& to) {
+    if (to.x > from.x) return RIGHT;
+    if (to.x < from.x) return LEFT;
+    return to.y > from.y ? DOWN : UP;
+}
@@ -0,0 +1,210 @@
+// Drawing for the snake window, kept apart from the game loop so it can be
+// driven on its own, e.g. by the draw benchmarks rendering offscreen.
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <string>
+#include "snake_engine.hpp"
+
+const int CELL_SIZE = 30;
+const int WINDOW_WIDTH = CELL_SIZE * GRID_WIDTH;
+const int WINDOW_HEIGHT = CELL_SIZE * GRID_HEIGHT + 80; // Extra space for score and instructions
+const sf::Color BODY_COLOR(0, 200, 0);      // Darker green for body
+const sf::Color HEAD_COLOR(50, 255, 50);    // Bright green for head
+const sf::Color FOOD_COLOR(255, 50, 50);    // Red
+
+// Moves a quad of `quads` onto a cell-sized square at `corner` (pixels)
+inline void placeCellQuad(sf::VertexArray& quads, std::size_t quad, const sf::Vector2f& corner, float cellSize,
+                          sf::Color color) {
+    sf::Vertex* v = &quads[quad * 4];
+    const float s = cellSize - 2;
+    v[0].position = sf::Vector2f(corner.x + 1, corner.y + 1);
+    v[1].position = sf::Vector2f(corner.x + 1 + s, corner.y + 1);
+    v[2].position = sf::Vector2f(corner.x + 1 + s, corner.y + 1 + s);
+    v[3].position = sf::Vector2f(corner.x + 1, corner.y + 1 + s);
+    for (int i = 0; i < 4; ++i) v[i].color = color;
+}
+
+// Score, a line of instructions under the play area, and the game-over
+// message over the whole window. The texts live as long as the HUD, and
+// their strings are only rebuilt when the score or instructions change.
+class SnakeHud {
+public:
+    SnakeHud(const sf::Font& font, float playHeight, const sf::Vector2f& windowSize)
+        : windowSize(windowSize), overlay(windowSize) {
+        scoreText.setFont(font);
+        scoreText.setCharacterSize(20);
+        scoreText.setFillColor(sf::Color::White);
+        scoreText.setPosition(10, playHeight + 5);
+
+        instructionsText.setFont(font);
+        instructionsText.setCharacterSize(14);
+        instructionsText.setFillColor(sf::Color(200, 200, 200));
+        instructionsText.setPosition(10, playHeight + 30);
+
+        overlay.setFillColor(sf::Color(0, 0, 0, 220)); // Semi-transparent black
+
+        gameOverText.setFont(font);
+        gameOverText.setString("GAME OVER!");
+        gameOverText.setCharacterSize(36);
+        gameOverText.setFillColor(sf::Color::Red);
+        gameOverText.setStyle(sf::Text::Bold);
+
+        finalScoreText.setFont(font);
+        finalScoreText.setCharacterSize(24);
+        finalScoreText.setFillColor(sf::Color::White);
+
+        exitText.setFont(font);
+        exitText.setString("Press ESC or close window to exit");
+        exitText.setCharacterSize(16);
+        exitText.setFillColor(sf::Color(180, 180, 180));
+    }
+
+    void setInstructions(const std::string& instructions) {
+        if (instructions != shownInstructions) {
+            shownInstructions = instructions;
+            instructionsText.setString(instructions);
+        }
+    }
+
+    // Returns the number of draw calls issued
+    int draw(sf::RenderTarget& target, const SnakeEngine& game) {
+        if (game.getScore() != shownScore) setScore(game.getScore());
+        int draws = 0;
+        auto submit = [&](const sf::Drawable& d) {
+            target.draw(d);
+            ++draws;
+        };
+        submit(scoreText);
+        submit(instructionsText);
+        if (game.isGameOver()) {
+            submit(overlay);
+            submit(gameOverText);
+            submit(finalScoreText);
+            submit(exitText);
+        }
+        return draws;
+    }
+
+private:
+    sf::Vector2f windowSize;
+    sf::Text scoreText;
+    sf::Text instructionsText;
+    sf::RectangleShape overlay;
+    sf::Text gameOverText;
+    sf::Text finalScoreText;
+    sf::Text exitText;
+    int shownScore = -1;
+    std::string shownInstructions;
+
+    // The game-over lines are centred here rather than in the constructor,
+    // because their bounds need the font loaded, which happens after the
+    // renderers are built
+    void setScore(int score) {
+        shownScore = score;
+        scoreText.setString("Score: " + std::to_string(score));
+        finalScoreText.setString("Final Score: " + std::to_string(score));
+        centre(gameOverText, -30);
+        centre(finalScoreText, 10);
+        centre(exitText, 45);
+    }
+
+    void centre(sf::Text& text, float dy) {
+        const sf::FloatRect textRect = text.getLocalBounds();
+        text.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+        text.setPosition(windowSize.x / 2.0f, windowSize.y / 2.0f + dy);
+    }
+};
+
+class SnakeRenderer {
+public:
+    explicit SnakeRenderer(const sf::Font& font)
+        : body(sf::Quads, std::size_t(GRID_WIDTH) * GRID_HEIGHT * 4), dynamic(sf::Quads, 3 * 4),
+          hud(font, CELL_SIZE * GRID_HEIGHT, sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        gameArea.setFillColor(sf::Color::Transparent);
+        gameArea.setOutlineColor(sf::Color(100, 100, 100));
+        gameArea.setOutlineThickness(2);
+        gameArea.setPosition(0, 0);
+        // One quad per cell, fixed in place; a cell shows by turning opaque
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                placeCellQuad(body, quadOf(Position(x, y)), sf::Vector2f(x * CELL_SIZE, y * CELL_SIZE), CELL_SIZE,
+                              sf::Color::Transparent);
+            }
+        }
+        hud.setInstructions("Use Arrow Keys or WASD to move | Tab autopilot | ESC to quit");
+    }
+
+    // Call after every move. The old head becomes a body cell and the new
+    // tail leaves the body array to be drawn on its own; nothing else changes.
+    void noteMove(const SnakeEngine& game) {
+        const SnakeBody& snake = game.getBody();
+        if (snake.size() > 1) showCell(snake[1], BODY_COLOR);
+        showCell(snake.back(), sf::Color::Transparent);
+    }
+
+    // Rebuilds the body array on the next draw, e.g. after setSnake()
+    void invalidate() { stale = true; }
+
+    // Draws the board, snake, score and game-over message. `alpha` is how far
+    // the current move has progressed, for interpolating head and tail.
+    // Returns the number of draw calls issued.
+    int draw(sf::RenderTarget& target, const SnakeEngine& game, float alpha) {
+        if (stale) rebuild(game);
+        int draws = 0;
+        auto submit = [&](const sf::Drawable& d) {
+            target.draw(d);
+            ++draws;
+        };
+        submit(gameArea);
+
+        // Cells between head and tail stay put, so they come from the cached
+        // array. Then food, tail and head, in that order so the head ends up
+        // on top. The head slides into its new cell and the tail out of its
+        // old one over the course of a move.
+        submit(body);
+        const SnakeBody& snake = game.getBody();
+        const float t = (game.isGameOver() || !game.hasMoved()) ? 1.0f : alpha;
+        const Position& previousTail = game.getPreviousTail();
+        const Position& head = snake[0];
+        const Position& neck = snake.size() > 1 ? snake[1] : head;
+        const Position& tail = snake.back();
+        const Position& tailFrom = game.ateFood() ? tail : previousTail;
+        // A snake that fills the grid leaves no food; its quad goes transparent
+        placeCellQuad(dynamic, 0, cellCorner(game.getFood().x, game.getFood().y), CELL_SIZE,
+                      game.hasFood() ? FOOD_COLOR : sf::Color::Transparent);
+        placeCellQuad(dynamic, 1,
+                      cellCorner(tailFrom.x + (tail.x - tailFrom.x) * t, tailFrom.y + (tail.y - tailFrom.y) * t),
+                      CELL_SIZE, snake.size() > 1 ? BODY_COLOR : sf::Color::Transparent);
+        placeCellQuad(dynamic, 2, cellCorner(neck.x + (head.x - neck.x) * t, neck.y + (head.y - neck.y) * t),
+                      CELL_SIZE, HEAD_COLOR);
+        submit(dynamic);
+
+        draws += hud.draw(target, game);
+        return draws;
+    }
+
+private:
+    sf::RectangleShape gameArea{sf::Vector2f(WINDOW_WIDTH, CELL_SIZE * GRID_HEIGHT)};
+    sf::VertexArray body;    // a quad per grid cell, opaque where a middle segment is
+    sf::VertexArray dynamic; // food, tail and head
+    SnakeHud hud;
+    bool stale = true;
+
+    static std::size_t quadOf(const Position& p) { return std::size_t(p.y) * GRID_WIDTH + p.x; }
+
+    static sf::Vector2f cellCorner(float x, float y) { return sf::Vector2f(x * CELL_SIZE, y * CELL_SIZE); }
+
+    void showCell(const Position& p, sf::Color color) {
+        sf::Vertex* v = &body[quadOf(p) * 4];
+        for (int i = 0; i < 4; ++i) v[i].color = color;
+    }
+
+    void rebuild(const SnakeEngine& game) {
+        stale = false;
+        for (std::size_t i = 0; i < body.getVertexCount(); ++i) body[i].color = sf::Color::Transparent;
+        const SnakeBody& snake = game.getBody();
+        for (std::size_t i = 1; i + 1 < snake.size(); ++i) showCell(snake[i], BODY_COLOR);
+    }
+};
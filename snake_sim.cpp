@@ -0,0 +1,188 @@
+// Headless snake arena: hundreds of bot snakes on one large grid, ticked on
+// every core. Reports tick time and snake-moves per second, plus a checksum
+// of the final state that must not depend on the thread count. --sweep runs
+// the same arena at 1, 2, 4, ... threads and checks that. --autopilot plays
+// single-snake games with the autopilot instead, as a soak test, and can log
+// their events with --telemetry. Needs no display and no SFML.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "snake_arena.hpp"
+#include "snake_ai.hpp"
+#include "telemetry.hpp"
+
+using std::size_t;
+using std::vector;
+
+struct SimOptions {
+    ArenaOptions arena;
+    long ticks = 2000;
+    bool sweep = false;
+    bool autopilot = false;
+    bool gridSet = false;
+    int games = 10;        // --autopilot: games to play
+    std::string telemetryPath; // --autopilot: log gameplay events here
+};
+
+struct RunResult {
+    unsigned threads = 0;
+    double seconds = 0;
+    vector<double> tickMs;
+    long long moves = 0, deaths = 0, eaten = 0;
+    int alive = 0;
+    std::uint64_t checksum = 0;
+};
+
+static void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--grid WxH] [--snakes N] [--food N] [--ticks N] [--threads N] [--seed N] [--sweep]\n"
+                 "       %s --autopilot [--grid WxH] [--games N] [--seed N] [--telemetry FILE]\n",
+                 argv0, argv0);
+}
+
+static bool parseArgs(int argc, char **argv, SimOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char *v = nullptr;
+        if (arg == "--grid" && (v = value())) {
+            if (std::sscanf(v, "%dx%d", &opt.arena.width, &opt.arena.height) != 2) return false;
+            opt.gridSet = true;
+        }
+        else if (arg == "--snakes" && (v = value())) opt.arena.snakes = std::atoi(v);
+        else if (arg == "--food" && (v = value())) opt.arena.food = std::atoi(v);
+        else if (arg == "--ticks" && (v = value())) opt.ticks = std::strtol(v, nullptr, 10);
+        else if (arg == "--threads" && (v = value())) opt.arena.threads = static_cast<unsigned>(std::strtoul(v, nullptr, 10));
+        else if (arg == "--seed" && (v = value())) opt.arena.seed = std::strtoull(v, nullptr, 10);
+        else if (arg == "--sweep") opt.sweep = true;
+        else if (arg == "--autopilot") opt.autopilot = true;
+        else if (arg == "--games" && (v = value())) opt.games = std::atoi(v);
+        else if (arg == "--telemetry" && (v = value())) opt.telemetryPath = v;
+        else return false;
+    }
+    return opt.arena.width >= 8 && opt.arena.height >= 1 && opt.arena.snakes > 0 && opt.arena.food >= 0 &&
+           opt.ticks > 0 && opt.games > 0;
+}
+
+static RunResult run(const SimOptions &opt, unsigned threads) {
+    ArenaOptions options = opt.arena;
+    options.threads = threads;
+    SnakeArena arena(options);
+    RunResult r;
+    r.threads = arena.threads();
+    r.tickMs.reserve(opt.ticks);
+    const auto start = std::chrono::steady_clock::now();
+    for (long t = 0; t < opt.ticks; ++t) {
+        const auto before = std::chrono::steady_clock::now();
+        const ArenaTickStats s = arena.tick();
+        r.tickMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count());
+        r.moves += s.moves;
+        r.deaths += s.deaths;
+        r.eaten += s.eaten;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.alive = arena.aliveCount();
+    r.checksum = arena.checksum();
+    return r;
+}
+
+static void print(const SimOptions &opt, RunResult &r) {
+    std::sort(r.tickMs.begin(), r.tickMs.end());
+    std::printf("threads=%u grid=%dx%d snakes=%d food=%d ticks=%ld\n", r.threads, opt.arena.width, opt.arena.height,
+                opt.arena.snakes, opt.arena.food, opt.ticks);
+    std::printf("  tick-ms mean=%.3f p50=%.3f p99=%.3f max=%.3f ticks/s=%.0f snake-moves/s=%.0f\n",
+                r.seconds * 1000 / opt.ticks, r.tickMs[r.tickMs.size() / 2], r.tickMs[r.tickMs.size() * 99 / 100],
+                r.tickMs.back(), opt.ticks / r.seconds, r.moves / r.seconds);
+    std::printf("  deaths=%lld eaten=%lld alive=%d checksum=%016llx\n", r.deaths, r.eaten, r.alive,
+                static_cast<unsigned long long>(r.checksum));
+}
+
+// Plays whole games with the autopilot, one after another, until each dies,
+// stalls (see autopilotStallLimit) or fills the grid, and reports scores and
+// how long each decision took
+static int runAutopilot(const SimOptions &opt) {
+    const int width = opt.gridSet ? opt.arena.width : GRID_WIDTH;
+    const int height = opt.gridSet ? opt.arena.height : GRID_HEIGHT;
+    const int cells = width * height;
+    SnakeAutopilot autopilot(width, height);
+    TelemetryLog telemetry;
+    if (!opt.telemetryPath.empty() && !telemetry.open(opt.telemetryPath)) {
+        std::fprintf(stderr, "cannot write telemetry to %s\n", opt.telemetryPath.c_str());
+        return 1;
+    }
+    SnakeTelemetry events(telemetry);
+    vector<double> decisionMs;
+    long long totalScore = 0, totalMoves = 0;
+    int stalled = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int g = 0; g < opt.games; ++g) {
+        const std::uint64_t seed = opt.arena.seed + static_cast<std::uint64_t>(g);
+        SnakeEngine game(width, height, seed);
+        long moves = 0, sinceFood = 0;
+        events.start(game);
+        while (!game.isGameOver() && sinceFood <= autopilotStallLimit(width, height)) {
+            const auto before = std::chrono::steady_clock::now();
+            const Direction d = autopilot.decide(game);
+            decisionMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count());
+            game.steer(d);
+            game.moveSnake();
+            events.moved(game);
+            ++moves;
+            sinceFood = game.ateFood() ? 0 : sinceFood + 1;
+        }
+        const int length = static_cast<int>(game.getBody().size());
+        const char *result = length == cells ? "filled" : game.isGameOver() ? "died" : "stalled";
+        stalled += !game.isGameOver();
+        totalScore += game.getScore();
+        totalMoves += moves;
+        std::printf("game=%d seed=%llu score=%d length=%d fill=%.1f%% moves=%ld %s\n", g,
+                    static_cast<unsigned long long>(seed), game.getScore(), length, 100.0 * length / cells, moves, result);
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(decisionMs.begin(), decisionMs.end());
+    double sum = 0;
+    for (double ms : decisionMs) sum += ms;
+    std::printf("grid=%dx%d games=%d stalled=%d mean-score=%.1f moves/s=%.0f decision-ms mean=%.4f p99=%.4f max=%.4f\n",
+                width, height, opt.games, stalled, double(totalScore) / opt.games, totalMoves / secs,
+                sum / decisionMs.size(), decisionMs[decisionMs.size() * 99 / 100], decisionMs.back());
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    SimOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opt.autopilot) return runAutopilot(opt);
+    if (!opt.sweep) {
+        RunResult r = run(opt, opt.arena.threads);
+        print(opt, r);
+        return 0;
+    }
+
+    // Doubling thread counts up to --threads (default: every core), each
+    // from the same seed, so speed-ups compare like with like
+    const unsigned most = opt.arena.threads ? opt.arena.threads : std::max(1u, std::thread::hardware_concurrency());
+    vector<RunResult> results;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, most)) {
+        results.push_back(run(opt, threads));
+        print(opt, results.back());
+        if (threads == most) break;
+    }
+    bool same = true;
+    for (const RunResult &r : results) {
+        std::printf("threads=%u speed-up=%.2f\n", r.threads, results.front().seconds / r.seconds);
+        same = same && r.checksum == results.front().checksum;
+    }
+    if (!same) {
+        std::printf("MISMATCH: final state depends on the thread count\n");
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Drawing for grids far larger than the window. A camera follows the head,
+// and the world is split into CHUNK_CELLS x CHUNK_CELLS chunks. Each visible
+// chunk keeps a vertex array of its body cells and is rebuilt only when a
+// move touched it, so a frame costs about the same for any world or snake
+// size. The head, tail and food are drawn on top each frame so they can be
+// interpolated.
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "snake_engine.hpp"
+#include "snake_render.hpp"
+
+const int WORLD_CELL_SIZE = 12;
+const int WORLD_VIEW_WIDTH = 960;
+const int WORLD_VIEW_HEIGHT = 720;
+const int WORLD_WINDOW_HEIGHT = WORLD_VIEW_HEIGHT + 80; // score and instructions below the view
+const int CHUNK_CELLS = 32;
+// Chunks off screen this long are dropped from the cache, by a sweep that
+// runs every CHUNK_SWEEP_FRAMES frames
+const std::chrono::seconds CHUNK_EVICT_AFTER(2);
+const std::uint64_t CHUNK_SWEEP_FRAMES = 30;
+
+class SnakeWorldRenderer {
+public:
+    explicit SnakeWorldRenderer(const sf::Font& font)
+        : dynamic(sf::Quads, 3 * 4),
+          hud(font, WORLD_VIEW_HEIGHT, sf::Vector2f(WORLD_VIEW_WIDTH, WORLD_WINDOW_HEIGHT)) {}
+
+    // Call after every move, so the chunks the move touched are rebuilt
+    void noteMove(const SnakeEngine& game) {
+        const SnakeBody& snake = game.getBody();
+        // The old head became a body cell, and the new tail left the body
+        // array to be drawn on its own
+        if (snake.size() > 1) markDirty(snake[1]);
+        markDirty(snake.back());
+        hudStale = true;
+    }
+
+    // Forgets every cached chunk, e.g. after the engine was reset
+    void invalidate() {
+        chunks.clear();
+        hudStale = true;
+    }
+
+    // Draws the visible part of the world, then the score and game-over
+    // message. Returns the number of draw calls issued.
+    int draw(sf::RenderTarget& target, const SnakeEngine& game, float alpha) {
+        ++frame;
+        const Clock::time_point now = Clock::now();
+        int draws = 0;
+        const SnakeBody& snake = game.getBody();
+        const float t = (game.isGameOver() || !game.hasMoved()) ? 1.0f : alpha;
+        const sf::Vector2f head = lerp(snake.size() > 1 ? snake[1] : snake[0], snake[0], t);
+        const sf::Vector2f tail =
+            game.ateFood() ? cellPosition(snake.back()) : lerp(game.getPreviousTail(), snake.back(), t);
+
+        const sf::View view = camera(game, head, target);
+        target.setView(view);
+
+        sf::RectangleShape world(worldPixels(game));
+        world.setFillColor(sf::Color(22, 22, 22));
+        world.setOutlineColor(sf::Color(100, 100, 100));
+        world.setOutlineThickness(2);
+        target.draw(world);
+        ++draws;
+
+        // Chunks overlapping the view
+        const sf::Vector2f centre = view.getCenter(), size = view.getSize();
+        const float chunkPixels = static_cast<float>(CHUNK_CELLS * WORLD_CELL_SIZE);
+        const int chunksX = (game.getWidth() + CHUNK_CELLS - 1) / CHUNK_CELLS;
+        const int chunksY = (game.getHeight() + CHUNK_CELLS - 1) / CHUNK_CELLS;
+        const int x0 = std::max(0, int((centre.x - size.x / 2) / chunkPixels));
+        const int y0 = std::max(0, int((centre.y - size.y / 2) / chunkPixels));
+        const int x1 = std::min(chunksX - 1, int((centre.x + size.x / 2) / chunkPixels));
+        const int y1 = std::min(chunksY - 1, int((centre.y + size.y / 2) / chunkPixels));
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                Chunk& chunk = chunks[chunkKey(cx, cy)];
+                if (chunk.dirty) build(chunk, game, cx, cy);
+                chunk.lastDrawn = now;
+                if (chunk.vertices.getVertexCount() == 0) continue;
+                sf::RenderStates states;
+                states.transform.translate(cx * chunkPixels, cy * chunkPixels);
+                target.draw(chunk.vertices, states);
+                ++draws;
+            }
+        }
+        if (frame % CHUNK_SWEEP_FRAMES == 0) evict(now);
+
+        // Food, tail and head, in that order so the head ends up on top
+        // With no food left its quad is parked far outside the world
+        const sf::Vector2f food = game.hasFood() ? cellPosition(game.getFood()) : sf::Vector2f(-1e6f, -1e6f);
+        placeCellQuad(dynamic, 0, food, WORLD_CELL_SIZE, FOOD_COLOR);
+        placeCellQuad(dynamic, 1, tail, WORLD_CELL_SIZE, BODY_COLOR);
+        placeCellQuad(dynamic, 2, head, WORLD_CELL_SIZE, HEAD_COLOR);
+        target.draw(dynamic);
+        ++draws;
+
+        target.setView(target.getDefaultView());
+        // The coordinates only change when the snake moves
+        if (hudStale) {
+            hudStale = false;
+            hud.setInstructions("Food at " + std::to_string(game.getFood().x) + "," +
+                                std::to_string(game.getFood().y) + " | head at " + std::to_string(snake[0].x) + "," +
+                                std::to_string(snake[0].y) + " | Arrows/WASD move | Tab autopilot | ESC quits");
+        }
+        draws += hud.draw(target, game);
+        return draws;
+    }
+
+    std::size_t cachedChunks() const { return chunks.size(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Chunk {
+        sf::VertexArray vertices{sf::Quads};
+        bool dirty = true;
+        Clock::time_point lastDrawn;
+    };
+
+    std::unordered_map<std::uint64_t, Chunk> chunks;
+    sf::VertexArray dynamic;
+    SnakeHud hud;
+    bool hudStale = true;
+    std::uint64_t frame = 0;
+
+    static std::uint64_t chunkKey(int cx, int cy) {
+        return (std::uint64_t(std::uint32_t(cy)) << 32) | std::uint32_t(cx);
+    }
+
+    static sf::Vector2f worldPixels(const SnakeEngine& game) {
+        return sf::Vector2f(static_cast<float>(game.getWidth()) * WORLD_CELL_SIZE,
+                            static_cast<float>(game.getHeight()) * WORLD_CELL_SIZE);
+    }
+
+    static sf::Vector2f cellPosition(const Position& p) {
+        return sf::Vector2f(static_cast<float>(p.x * WORLD_CELL_SIZE), static_cast<float>(p.y * WORLD_CELL_SIZE));
+    }
+
+    static sf::Vector2f lerp(const Position& from, const Position& to, float t) {
+        return sf::Vector2f((from.x + (to.x - from.x) * t) * WORLD_CELL_SIZE,
+                            (from.y + (to.y - from.y) * t) * WORLD_CELL_SIZE);
+    }
+
+    void markDirty(const Position& p) {
+        auto it = chunks.find(chunkKey(p.x / CHUNK_CELLS, p.y / CHUNK_CELLS));
+        if (it != chunks.end()) it->second.dirty = true;
+    }
+
+    // Centres the view on the head, but keeps it inside the world where the
+    // world is larger than the view
+    sf::View camera(const SnakeEngine& game, const sf::Vector2f& head, const sf::RenderTarget& target) const {
+        const sf::Vector2f viewSize(static_cast<float>(WORLD_VIEW_WIDTH), static_cast<float>(WORLD_VIEW_HEIGHT));
+        const sf::Vector2f worldSize = worldPixels(game);
+        auto axis = [](float want, float view, float world) {
+            if (world <= view) return world / 2;
+            return std::min(std::max(want, view / 2), world - view / 2);
+        };
+        const float half = WORLD_CELL_SIZE / 2.0f;
+        const sf::Vector2f centre(axis(head.x + half, viewSize.x, worldSize.x), axis(head.y + half, viewSize.y, worldSize.y));
+        sf::View view(centre, viewSize);
+        const sf::Vector2u targetSize = target.getSize();
+        view.setViewport(sf::FloatRect(0, 0, viewSize.x / targetSize.x, viewSize.y / targetSize.y));
+        return view;
+    }
+
+    // One quad per body cell in the chunk, in chunk-local pixels. The head
+    // and tail are left out; draw() puts them in between cells.
+    void build(Chunk& chunk, const SnakeEngine& game, int cx, int cy) {
+        chunk.vertices.clear();
+        chunk.dirty = false;
+        const SnakeBody& snake = game.getBody();
+        const Position& head = snake.front();
+        const Position& tail = snake.back();
+        const int left = cx * CHUNK_CELLS, top = cy * CHUNK_CELLS;
+        const int right = std::min(left + CHUNK_CELLS, game.getWidth());
+        const int bottom = std::min(top + CHUNK_CELLS, game.getHeight());
+        for (int y = top; y < bottom; ++y) {
+            for (int x = left; x < right; ++x) {
+                const Position p(x, y);
+                if (!game.isSnakePosition(p) || p == head || p == tail) continue;
+                const float px = static_cast<float>((x - left) * WORLD_CELL_SIZE + 1);
+                const float py = static_cast<float>((y - top) * WORLD_CELL_SIZE + 1);
+                const float s = static_cast<float>(WORLD_CELL_SIZE - 2);
+                chunk.vertices.append(sf::Vertex(sf::Vector2f(px, py), BODY_COLOR));
+                chunk.vertices.append(sf::Vertex(sf::Vector2f(px + s, py), BODY_COLOR));
+                chunk.vertices.append(sf::Vertex(sf::Vector2f(px + s, py + s), BODY_COLOR));
+                chunk.vertices.append(sf::Vertex(sf::Vector2f(px, py + s), BODY_COLOR));
+            }
+        }
+    }
+
+    void evict(Clock::time_point now) {
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            if (now - it->second.lastDrawn > CHUNK_EVICT_AFTER) it = chunks.erase(it);
+            else ++it;
+        }
+    }
+};
@@ -0,0 +1,179 @@
+// Snapshot files: a fixed-layout game snapshot, kept in two slots. The writer
+// keeps the file mapped read-write, so the engine writes its state straight
+// into the page cache and saving costs no more than a memcpy. Each save goes
+// into the older slot and is stamped with the next generation only once its
+// payload is complete, so the newest complete save always survives a save
+// that is cut short.
+//
+// Layout (native byte order; a snapshot resumes on the machine that wrote it):
+//   two slots, the second starting halfway through the file, each:
+//   "GSNP"  u16 version  u16 game  u32 payload bytes  u32 FNV-1a of
+//   generation and payload  u64 generation  u64 reserved, then the payload:
+//   TetrisEngine::Snapshot, or SnakeSnapshotHeader and its cells
+// Readers take the valid slot with the highest generation.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.hpp"
+
+static constexpr char SNAPSHOT_MAGIC[4] = {'G', 'S', 'N', 'P'};
+// Version 2: two slots with generations
+static constexpr std::uint16_t SNAPSHOT_VERSION = 2;
+static constexpr std::size_t SNAPSHOT_SLOT_HEADER_SIZE = 32;
+// Which game a snapshot belongs to
+static constexpr std::uint16_t SNAPSHOT_TETRIS = 1, SNAPSHOT_SNAKE = 2;
+
+// Bytes from one slot to the next: a header and the payload, rounded up to
+// a cache line so both payloads start equally aligned
+inline std::size_t snapshotSlotStride(std::size_t payloadSize) {
+    return (SNAPSHOT_SLOT_HEADER_SIZE + payloadSize + 63) / 64 * 64;
+}
+
+inline std::uint32_t snapshotChecksum(std::uint64_t generation, const unsigned char *data, std::size_t size) {
+    std::uint32_t h = 2166136261u;
+    for (int i = 0; i < 8; ++i) h = (h ^ static_cast<unsigned char>(generation >> (8 * i))) * 16777619u;
+    for (std::size_t i = 0; i < size; ++i) h = (h ^ data[i]) * 16777619u;
+    return h;
+}
+
+// The newest complete save for `game` among the two slots of a snapshot file
+// of fileSize bytes, or -1 when there is none
+inline int newestSnapshotSlot(const unsigned char *file, std::size_t fileSize, std::uint16_t game,
+                              std::size_t &payloadSize, std::uint64_t &generation) {
+    int newest = -1;
+    const std::size_t stride = fileSize / 2;
+    if (fileSize % 2 != 0 || stride < SNAPSHOT_SLOT_HEADER_SIZE) return -1;
+    for (int slot = 0; slot < 2; ++slot) {
+        const unsigned char *p = file + slot * stride;
+        std::uint16_t version, slotGame;
+        std::uint32_t size, sum;
+        std::uint64_t gen;
+        std::memcpy(&version, p + 4, 2);
+        std::memcpy(&slotGame, p + 6, 2);
+        std::memcpy(&size, p + 8, 4);
+        std::memcpy(&sum, p + 12, 4);
+        std::memcpy(&gen, p + 16, 8);
+        if (std::memcmp(p, SNAPSHOT_MAGIC, 4) != 0 || version != SNAPSHOT_VERSION || slotGame != game ||
+            snapshotSlotStride(size) != stride || snapshotChecksum(gen, p + SNAPSHOT_SLOT_HEADER_SIZE, size) != sum) {
+            continue;
+        }
+        if (newest < 0 || gen > generation) {
+            newest = slot;
+            payloadSize = size;
+            generation = gen;
+        }
+    }
+    return newest;
+}
+
+// Write side: maps the whole file read-write. Fill payload(), then commit().
+class SnapshotWriter {
+public:
+    SnapshotWriter() = default;
+    ~SnapshotWriter() { close(); }
+
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+    // Opens `path` for saves of payloadSize bytes. A missing or empty file is
+    // created at its full size; an existing one is only taken over when it
+    // already holds saves of this game and size, and its newest save stays
+    // intact until the next commit(). Anything else is left alone and open()
+    // returns false.
+    bool open(const char *path, std::uint16_t game, std::size_t payloadSize) {
+        close();
+        const int fd = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        const std::size_t length = 2 * snapshotSlotStride(payloadSize);
+        struct stat st;
+        if (fstat(fd, &st) != 0 ||
+            (st.st_size == 0 && ftruncate(fd, static_cast<off_t>(length)) != 0) ||
+            (st.st_size != 0 && static_cast<std::size_t>(st.st_size) != length)) {
+            ::close(fd);
+            return false;
+        }
+        void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd); // the mapping keeps the file alive
+        if (p == MAP_FAILED) return false;
+        ptr = static_cast<unsigned char *>(p);
+        mappedSize = length;
+        size = payloadSize;
+        gameId = game;
+
+        std::size_t savedSize = 0;
+        generation = 0;
+        const int newest = newestSnapshotSlot(ptr, mappedSize, game, savedSize, generation);
+        if (newest < 0 ? !(blankSlot(0) && blankSlot(1)) : savedSize != payloadSize) {
+            close(); // someone else's file, or another game's
+            return false;
+        }
+        next = newest == 0 ? 1 : 0;
+        return true;
+    }
+
+    bool isOpen() const { return ptr != nullptr; }
+    // Payload of the slot the next commit() completes; cache-line aligned
+    // plus the header, so any snapshot struct can live here
+    unsigned char *payload() { return slot(next) + SNAPSHOT_SLOT_HEADER_SIZE; }
+    std::size_t payloadSize() const { return size; }
+
+    // Stamps the header over a payload that has been written in full, which
+    // makes it the newest save, and asks the kernel to start writing it back
+    // without waiting for it
+    void commit() {
+        unsigned char *p = slot(next);
+        const std::uint16_t version = SNAPSHOT_VERSION;
+        const std::uint32_t bytes = static_cast<std::uint32_t>(size);
+        const std::uint64_t gen = generation + 1;
+        const std::uint32_t sum = snapshotChecksum(gen, payload(), size);
+        std::memcpy(p, SNAPSHOT_MAGIC, 4);
+        std::memcpy(p + 4, &version, 2);
+        std::memcpy(p + 6, &gameId, 2);
+        std::memcpy(p + 8, &bytes, 4);
+        std::memcpy(p + 12, &sum, 4);
+        std::memcpy(p + 16, &gen, 8);
+        std::memset(p + 24, 0, 8);
+        msync(ptr, mappedSize, MS_ASYNC);
+        generation = gen;
+        next ^= 1;
+    }
+
+    void close() {
+        if (ptr) munmap(ptr, mappedSize);
+        ptr = nullptr;
+        mappedSize = size = 0;
+    }
+
+private:
+    unsigned char *ptr = nullptr;
+    std::size_t mappedSize = 0, size = 0;
+    std::uint16_t gameId = 0;
+    std::uint64_t generation = 0; // of the newest complete save
+    int next = 0;                 // slot the next save goes into
+
+    unsigned char *slot(int i) { return ptr + i * (mappedSize / 2); }
+
+    // A slot header never written: what open() leaves in a file it created
+    bool blankSlot(int i) {
+        const unsigned char *p = slot(i);
+        for (std::size_t j = 0; j < SNAPSHOT_SLOT_HEADER_SIZE; ++j) {
+            if (p[j]) return false;
+        }
+        return true;
+    }
+};
+
+// Read side: the payload of the newest complete save for `game` in a mapped
+// snapshot file, or null when it holds none
+inline const unsigned char *snapshotPayload(const MappedFile &file, std::uint16_t game, std::size_t &payloadSize) {
+    std::uint64_t generation = 0;
+    const int slot = newestSnapshotSlot(file.data(), file.size(), game, payloadSize, generation);
+    if (slot < 0) return nullptr;
+    return file.data() + slot * (file.size() / 2) + SNAPSHOT_SLOT_HEADER_SIZE;
+}
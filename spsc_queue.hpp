@@ -0,0 +1,58 @@
+// Bounded single-producer, single-consumer queue. One thread pushes and one
+// other thread pops; neither ever blocks, locks or allocates. Each side keeps
+// a cached copy of the other side's index, so the shared cache lines are only
+// touched when the queue looks full or empty.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer only. Returns false, leaving the queue unchanged, when full.
+    bool push(const T &value) {
+        const std::size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headCache == Capacity) {
+            headCache = headIndex.load(std::memory_order_acquire);
+            if (tail - headCache == Capacity) return false;
+        }
+        slots[tail & MASK] = value;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when empty.
+    bool pop(T &out) {
+        const std::size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailCache) {
+            tailCache = tailIndex.load(std::memory_order_acquire);
+            if (head == tailCache) return false;
+        }
+        out = slots[head & MASK];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; only a snapshot while the other side is running
+    std::size_t size() const {
+        return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    // Consumer side
+    alignas(64) std::atomic<std::size_t> headIndex{0};
+    std::size_t tailCache = 0;
+    // Producer side
+    alignas(64) std::atomic<std::size_t> tailIndex{0};
+    std::size_t headCache = 0;
+
+    alignas(64) std::array<T, Capacity> slots{};
+};
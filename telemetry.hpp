@@ -0,0 +1,292 @@
+// Gameplay telemetry: fixed-size binary event records, written to disk
+// without holding up the game. The game thread stamps each event and pushes
+// it into a lock-free ring; a writer thread drains the ring in batches and
+// appends them to a log file. When the file reaches its size limit it is
+// rotated, logrotate-style: PATH becomes PATH.1, PATH.1 becomes PATH.2, and
+// so on, and the oldest file beyond the limit is deleted. If the ring is
+// full the event is dropped and counted; the game never waits.
+//
+// File layout (native byte order):
+//   "TLOG"  u16 version  u16 record size  u64 reserved
+//   records: TelemetryEvent, back to back
+// A file cut short mid-record is read up to its last whole record.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+#include "tetris_engine.hpp"
+#include "snake_engine.hpp"
+
+static constexpr char TELEMETRY_MAGIC[4] = {'T', 'L', 'O', 'G'};
+static constexpr std::uint16_t TELEMETRY_VERSION = 1;
+static constexpr std::size_t TELEMETRY_HEADER_SIZE = 16;
+// Which game an event comes from
+static constexpr std::uint8_t TELEMETRY_TETRIS = 1, TELEMETRY_SNAKE = 2;
+
+enum class TelemetryKind : std::uint8_t {
+    GameStart,
+    PieceSpawn, // value: piece kind; x, y: where it appeared
+    PieceLock,  // value: piece kind; count: rotation; x, y: where it locked
+    LineClear,  // count: lines cleared at once; value: score after
+    LevelUp,    // value: the new level
+    FoodEaten,  // value: snake length after; x, y: the food's cell
+    GameOver,   // value: final score; x, y: the snake's head, for snake
+    Count
+};
+
+struct TelemetryEvent {
+    std::uint64_t timeNs; // wall-clock nanoseconds since the Unix epoch
+    std::uint64_t step;   // engine tick (Tetris) or move number (snake)
+    std::uint8_t game;
+    TelemetryKind kind;
+    std::uint16_t count;
+    std::int32_t value;
+    std::int32_t x, y;
+};
+static_assert(sizeof(TelemetryEvent) == 32, "records have a fixed layout");
+
+class TelemetryLog {
+public:
+    static constexpr std::size_t RING_SIZE = 8192; // events in flight at once
+
+    TelemetryLog() = default;
+    TelemetryLog(const TelemetryLog &) = delete;
+    TelemetryLog &operator=(const TelemetryLog &) = delete;
+    ~TelemetryLog() { close(); }
+
+    // Appends to `path`, rotating it once it passes maxFileBytes and keeping
+    // at most keepFiles rotated files. Starts the writer.
+    bool open(const std::string &path, std::size_t maxFileBytes = 64u << 20, int keepFiles = 8) {
+        close();
+        this->path = path;
+        maxBytes = std::max<std::size_t>(maxFileBytes, TELEMETRY_HEADER_SIZE + sizeof(TelemetryEvent));
+        keep = std::max(keepFiles, 0);
+        if (!openFile()) return false;
+        // Stamps are steady-clock intervals from a wall-clock start, so they
+        // never go backwards during a session
+        steadyStart = std::chrono::steady_clock::now();
+        wallStartNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                     std::chrono::system_clock::now().time_since_epoch())
+                                                     .count());
+        offered = dropped = 0;
+        written = rotations = writeErrors = 0;
+        stopping = false;
+        writer = std::thread([this] { writerLoop(); });
+        return true;
+    }
+
+    bool isOpen() const { return writer.joinable(); }
+
+    // Game thread. Stamps the event with the current time and queues it.
+    void record(TelemetryEvent event) {
+        if (!isOpen()) return;
+        event.timeNs = wallStartNs + static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                    std::chrono::steady_clock::now() - steadyStart)
+                                                                    .count());
+        ++offered;
+        if (!ring.push(event)) ++dropped;
+    }
+
+    // Writes out everything already queued, stops the writer and reports
+    void close() {
+        if (!writer.joinable()) return;
+        stopping = true;
+        writer.join();
+        if (stream) std::fclose(stream);
+        stream = nullptr;
+        std::fprintf(stderr, "telemetry: %llu events written, %llu dropped, %llu rotations, %llu write errors\n",
+                     static_cast<unsigned long long>(written), static_cast<unsigned long long>(dropped),
+                     static_cast<unsigned long long>(rotations), static_cast<unsigned long long>(writeErrors));
+    }
+
+    std::uint64_t eventsOffered() const { return offered; }
+    std::uint64_t eventsDropped() const { return dropped; }
+
+private:
+    static constexpr std::size_t BATCH = 1024;
+
+    std::string path;
+    std::size_t maxBytes = 0;
+    int keep = 0;
+    SpscQueue<TelemetryEvent, RING_SIZE> ring; // game thread -> writer
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+
+    // Game thread only
+    std::chrono::steady_clock::time_point steadyStart;
+    std::uint64_t wallStartNs = 0;
+    std::uint64_t offered = 0, dropped = 0;
+
+    // Writer only, read after it has been joined
+    std::FILE *stream = nullptr;
+    std::size_t fileBytes = 0;
+    std::uint64_t written = 0, rotations = 0, writeErrors = 0;
+
+    bool openFile() {
+        stream = std::fopen(path.c_str(), "ab");
+        if (!stream) return false;
+        std::fseek(stream, 0, SEEK_END);
+        fileBytes = static_cast<std::size_t>(std::ftell(stream));
+        if (fileBytes == 0) {
+            unsigned char header[TELEMETRY_HEADER_SIZE] = {};
+            const std::uint16_t version = TELEMETRY_VERSION, recordSize = sizeof(TelemetryEvent);
+            std::memcpy(header, TELEMETRY_MAGIC, 4);
+            std::memcpy(header + 4, &version, 2);
+            std::memcpy(header + 6, &recordSize, 2);
+            fileBytes = std::fwrite(header, 1, sizeof header, stream);
+        }
+        return true;
+    }
+
+    // PATH.keep is deleted and every other file moves up by one
+    bool rotate() {
+        std::fclose(stream);
+        stream = nullptr;
+        if (keep == 0) {
+            std::remove(path.c_str());
+        } else {
+            std::remove((path + "." + std::to_string(keep)).c_str());
+            for (int i = keep - 1; i >= 1; --i) {
+                std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+            }
+            std::rename(path.c_str(), (path + ".1").c_str());
+        }
+        ++rotations;
+        return openFile();
+    }
+
+    void writerLoop() {
+        std::vector<TelemetryEvent> batch(BATCH);
+        for (;;) {
+            std::size_t n = 0;
+            while (n < BATCH && ring.pop(batch[n])) ++n;
+            if (n == 0) {
+                if (stopping) {
+                    if (ring.size() == 0) return;
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                continue;
+            }
+            writeBatch(batch.data(), n);
+        }
+    }
+
+    // Whole records only, so a file never splits one across a rotation
+    void writeBatch(const TelemetryEvent *events, std::size_t n) {
+        while (n > 0) {
+            if (!stream && !openFile()) {
+                writeErrors += n;
+                return;
+            }
+            const std::size_t room = maxBytes > fileBytes ? (maxBytes - fileBytes) / sizeof(TelemetryEvent) : 0;
+            const std::size_t take = std::min(n, room);
+            if (take > 0) {
+                const std::size_t done = std::fwrite(events, sizeof(TelemetryEvent), take, stream);
+                fileBytes += done * sizeof(TelemetryEvent);
+                written += done;
+                writeErrors += take - done;
+                events += take;
+                n -= take;
+            }
+            if (n > 0 && !rotate()) {
+                writeErrors += n;
+                return;
+            }
+        }
+        std::fflush(stream);
+    }
+};
+
+// Turns changes in a TetrisEngine into events. Call start() for each new
+// game and observe() after every apply() or tick().
+class TetrisTelemetry {
+public:
+    explicit TetrisTelemetry(TelemetryLog &log) : log(log) {}
+
+    void start(const TetrisEngine &engine) {
+        note(engine);
+        over = engine.isGameOver();
+        emit(engine, TelemetryKind::GameStart, 0, 0);
+        spawned(engine);
+    }
+
+    void observe(const TetrisEngine &engine) {
+        if (!log.isOpen() || engine.getPiecesSpawned() == pieces) {
+            landing = engine.getGhost();
+            return;
+        }
+        emit(engine, TelemetryKind::PieceLock, landing.rotation, landing.kind, landing.x, landing.y);
+        if (engine.getLinesCleared() != lines) {
+            emit(engine, TelemetryKind::LineClear, engine.getLinesCleared() - lines, engine.getScore());
+        }
+        if (engine.getLevel() != level) emit(engine, TelemetryKind::LevelUp, 0, engine.getLevel());
+        if (engine.isGameOver() && !over) {
+            emit(engine, TelemetryKind::GameOver, 0, engine.getScore());
+            over = true;
+        } else {
+            spawned(engine);
+        }
+        note(engine);
+    }
+
+private:
+    TelemetryLog &log;
+    int pieces = 0, lines = 0, level = 0;
+    bool over = false;
+    Piece landing{}; // where the active piece would lock: a hard drop moves it there first
+
+    void note(const TetrisEngine &engine) {
+        pieces = engine.getPiecesSpawned();
+        lines = engine.getLinesCleared();
+        level = engine.getLevel();
+        landing = engine.getGhost();
+    }
+
+    void spawned(const TetrisEngine &engine) {
+        const Piece &p = engine.getCurrent();
+        emit(engine, TelemetryKind::PieceSpawn, 0, p.kind, p.x, p.y);
+    }
+
+    void emit(const TetrisEngine &engine, TelemetryKind kind, int count, int value, int x = 0, int y = 0) {
+        log.record(TelemetryEvent{0, engine.getTick(), TELEMETRY_TETRIS, kind, static_cast<std::uint16_t>(count),
+                                  value, x, y});
+    }
+};
+
+// The same for a SnakeEngine: start() for each new game, moved() after every
+// moveSnake()
+class SnakeTelemetry {
+public:
+    explicit SnakeTelemetry(TelemetryLog &log) : log(log) {}
+
+    void start(const SnakeEngine &engine) {
+        moves = 0;
+        emit(engine, TelemetryKind::GameStart, 0);
+    }
+
+    void moved(const SnakeEngine &engine) {
+        ++moves;
+        // A fatal move leaves ateFood() from the move before it
+        if (engine.isGameOver()) emit(engine, TelemetryKind::GameOver, engine.getScore());
+        else if (engine.ateFood()) emit(engine, TelemetryKind::FoodEaten, static_cast<int>(engine.getBody().size()));
+    }
+
+private:
+    TelemetryLog &log;
+    std::uint64_t moves = 0;
+
+    void emit(const SnakeEngine &engine, TelemetryKind kind, int value) {
+        const Position &head = engine.getBody().front();
+        log.record(TelemetryEvent{0, moves, TELEMETRY_SNAKE, kind, 0, value, head.x, head.y});
+    }
+};
@@ -0,0 +1,218 @@
+// Offline reader for telemetry logs (telemetry.hpp). Memory-maps every file
+// given, splits the records into chunks and aggregates them on every core,
+// then prints event counts, line-clear and game-over statistics per game.
+// Rotated files (PATH.1, PATH.2, ...) can be passed together with PATH.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "telemetry.hpp"
+#include "mapped_file.hpp"
+
+using std::size_t;
+using std::vector;
+
+static constexpr size_t CHUNK_RECORDS = 1 << 18;
+static constexpr int GAMES = 3;        // indexed by the event's game byte
+static constexpr int MAX_CLEAR = 4;    // line clears of more rows are counted as 4
+
+static const char *KIND_NAMES[] = {"game-start", "piece-spawn", "piece-lock", "line-clear",
+                                   "level-up",   "food-eaten",  "game-over"};
+static_assert(sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0]) == static_cast<size_t>(TelemetryKind::Count),
+              "every kind needs a name");
+
+struct GameTotals {
+    std::uint64_t kinds[static_cast<int>(TelemetryKind::Count)] = {};
+    std::uint64_t clears[MAX_CLEAR + 1] = {}; // by lines cleared at once
+    std::uint64_t lines = 0;
+    std::uint64_t scoreSum = 0;               // over game-over events
+    std::int32_t maxScore = 0, maxLevel = 0, maxLength = 0;
+};
+
+struct Totals {
+    GameTotals games[GAMES];
+    std::uint64_t records = 0, unknown = 0;
+    std::uint64_t firstNs = UINT64_MAX, lastNs = 0;
+
+    void add(const TelemetryEvent &e) {
+        ++records;
+        const int kind = static_cast<int>(e.kind);
+        if (e.game >= GAMES || kind >= static_cast<int>(TelemetryKind::Count)) {
+            ++unknown;
+            return;
+        }
+        firstNs = std::min(firstNs, e.timeNs);
+        lastNs = std::max(lastNs, e.timeNs);
+        GameTotals &g = games[e.game];
+        ++g.kinds[kind];
+        switch (e.kind) {
+            case TelemetryKind::LineClear:
+                ++g.clears[std::min<int>(e.count, MAX_CLEAR)];
+                g.lines += e.count;
+                break;
+            case TelemetryKind::LevelUp:
+                g.maxLevel = std::max(g.maxLevel, e.value);
+                break;
+            case TelemetryKind::FoodEaten:
+                g.maxLength = std::max(g.maxLength, e.value);
+                break;
+            case TelemetryKind::GameOver:
+                g.scoreSum += static_cast<std::uint64_t>(std::max(e.value, 0));
+                g.maxScore = std::max(g.maxScore, e.value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void merge(const Totals &o) {
+        for (int i = 0; i < GAMES; ++i) {
+            GameTotals &g = games[i];
+            const GameTotals &h = o.games[i];
+            for (int k = 0; k < static_cast<int>(TelemetryKind::Count); ++k) g.kinds[k] += h.kinds[k];
+            for (int c = 0; c <= MAX_CLEAR; ++c) g.clears[c] += h.clears[c];
+            g.lines += h.lines;
+            g.scoreSum += h.scoreSum;
+            g.maxScore = std::max(g.maxScore, h.maxScore);
+            g.maxLevel = std::max(g.maxLevel, h.maxLevel);
+            g.maxLength = std::max(g.maxLength, h.maxLength);
+        }
+        records += o.records;
+        unknown += o.unknown;
+        firstNs = std::min(firstNs, o.firstNs);
+        lastNs = std::max(lastNs, o.lastNs);
+    }
+};
+
+// A run of records in one mapped file
+struct Chunk {
+    const unsigned char *data;
+    size_t count;
+};
+
+// Checks the header and returns the number of whole records, or -1 when the
+// file is not a telemetry log this reader understands
+static long long recordCount(const MappedFile &file) {
+    if (file.size() < TELEMETRY_HEADER_SIZE) return -1;
+    std::uint16_t version, recordSize;
+    std::memcpy(&version, file.data() + 4, 2);
+    std::memcpy(&recordSize, file.data() + 6, 2);
+    if (std::memcmp(file.data(), TELEMETRY_MAGIC, 4) != 0 || version != TELEMETRY_VERSION ||
+        recordSize != sizeof(TelemetryEvent)) {
+        return -1;
+    }
+    return static_cast<long long>((file.size() - TELEMETRY_HEADER_SIZE) / sizeof(TelemetryEvent));
+}
+
+static void printGame(const char *name, const GameTotals &g) {
+    std::uint64_t events = 0;
+    for (std::uint64_t n : g.kinds) events += n;
+    if (events == 0) return;
+    std::printf("%s: events=%llu\n", name, static_cast<unsigned long long>(events));
+    std::printf(" ");
+    for (int k = 0; k < static_cast<int>(TelemetryKind::Count); ++k) {
+        if (g.kinds[k]) std::printf(" %s=%llu", KIND_NAMES[k], static_cast<unsigned long long>(g.kinds[k]));
+    }
+    std::printf("\n");
+    const std::uint64_t over = g.kinds[static_cast<int>(TelemetryKind::GameOver)];
+    if (g.kinds[static_cast<int>(TelemetryKind::LineClear)]) {
+        std::printf("  lines=%llu singles=%llu doubles=%llu triples=%llu tetrises=%llu max-level=%d\n",
+                    static_cast<unsigned long long>(g.lines), static_cast<unsigned long long>(g.clears[1]),
+                    static_cast<unsigned long long>(g.clears[2]), static_cast<unsigned long long>(g.clears[3]),
+                    static_cast<unsigned long long>(g.clears[4]), g.maxLevel);
+    }
+    if (g.maxLength) std::printf("  max-length=%d\n", g.maxLength);
+    if (over) {
+        std::printf("  games-over=%llu mean-final-score=%.1f max-final-score=%d\n",
+                    static_cast<unsigned long long>(over), double(g.scoreSum) / over, g.maxScore);
+    }
+}
+
+static void usage(const char *argv0) {
+    std::fprintf(stderr, "usage: %s [--threads N] LOG...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    unsigned threads = 0;
+    vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg.compare(0, 2, "--") == 0) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const auto start = std::chrono::steady_clock::now();
+    vector<std::unique_ptr<MappedFile>> files;
+    vector<Chunk> chunks;
+    size_t bytes = 0;
+    bool bad = false;
+    for (const std::string &path : paths) {
+        auto file = std::make_unique<MappedFile>(path.c_str());
+        const long long count = file->isOpen() ? recordCount(*file) : -1;
+        if (count < 0) {
+            std::fprintf(stderr, "%s: not a telemetry log\n", path.c_str());
+            bad = true;
+            continue;
+        }
+        if ((file->size() - TELEMETRY_HEADER_SIZE) % sizeof(TelemetryEvent)) {
+            std::fprintf(stderr, "%s: ends mid-record; reading its %lld whole records\n", path.c_str(), count);
+        }
+        bytes += file->size();
+        const unsigned char *records = file->data() + TELEMETRY_HEADER_SIZE;
+        for (size_t first = 0; first < static_cast<size_t>(count); first += CHUNK_RECORDS) {
+            chunks.push_back(Chunk{records + first * sizeof(TelemetryEvent),
+                                   std::min(CHUNK_RECORDS, static_cast<size_t>(count) - first)});
+        }
+        files.push_back(std::move(file));
+    }
+
+    // Workers take chunks in turn and keep their own totals
+    threads = std::min<unsigned>(threads, std::max<size_t>(chunks.size(), 1));
+    vector<Totals> partial(threads);
+    std::atomic<size_t> nextChunk{0};
+    vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            Totals &totals = partial[t];
+            for (size_t c; (c = nextChunk.fetch_add(1)) < chunks.size();) {
+                const Chunk &chunk = chunks[c];
+                for (size_t i = 0; i < chunk.count; ++i) {
+                    TelemetryEvent e;
+                    std::memcpy(&e, chunk.data + i * sizeof e, sizeof e);
+                    totals.add(e);
+                }
+            }
+        });
+    }
+    for (std::thread &w : workers) w.join();
+    Totals totals;
+    for (const Totals &p : partial) totals.merge(p);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("files=%zu records=%llu unknown=%llu span=%.1fs\n", files.size(),
+                static_cast<unsigned long long>(totals.records), static_cast<unsigned long long>(totals.unknown),
+                totals.records > totals.unknown ? (totals.lastNs - totals.firstNs) / 1e9 : 0.0);
+    printGame("tetris", totals.games[TELEMETRY_TETRIS]);
+    printGame("snake", totals.games[TELEMETRY_SNAKE]);
+    std::printf("read %.1f MB in %.3fs with %u threads (%.0f records/s)\n", bytes / 1e6, seconds, threads,
+                totals.records / std::max(seconds, 1e-9));
+    return bad ? 2 : 0;
+}
@@ -0,0 +1,349 @@
+// Autopilot for the Tetris engine. Every reachable resting place of a piece
+// is found with a breadth-first search over the player's own moves (shifts,
+// kicked rotations, soft drops), each resulting board is scored with a
+// linear heuristic, and a beam search looks ahead over the known upcoming
+// pieces. Beam expansion is spread across a TaskPool.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "tetris_engine.hpp"
+#include "thread_pool.hpp"
+
+// Heuristic weights; the defaults are a well-known hand-tuned set
+struct AiWeights {
+    float height = -0.510066f;    // sum of column heights
+    float lines = 0.760666f;      // lines cleared by the placement
+    float holes = -0.35663f;      // empty cells with a filled cell above
+    float bumpiness = -0.184483f; // sum of height differences between neighbours
+};
+
+struct BoardFeatures {
+    int aggregateHeight = 0;
+    int holes = 0;
+    int bumpiness = 0;
+    int maxHeight = 0;
+};
+
+inline BoardFeatures boardFeatures(const RowMask *board) {
+    BoardFeatures f;
+    std::array<int, COLS> heights{};
+    RowMask seen = 0; // columns with a filled cell at or above this row
+    for (int r = 0; r < ROWS; ++r) {
+        unsigned fresh = board[r] & ~seen & FULL_ROW;
+        while (fresh) {
+            heights[__builtin_ctz(fresh)] = ROWS - r;
+            fresh &= fresh - 1;
+        }
+        seen = static_cast<RowMask>(seen | board[r]);
+        f.holes += __builtin_popcount(seen & ~board[r] & FULL_ROW);
+    }
+    for (int c = 0; c < COLS; ++c) {
+        f.aggregateHeight += heights[c];
+        f.maxHeight = std::max(f.maxHeight, heights[c]);
+        if (c > 0) f.bumpiness += std::abs(heights[c] - heights[c - 1]);
+    }
+    return f;
+}
+
+inline float evaluateBoard(const RowMask *board, const AiWeights &w) {
+    const BoardFeatures f = boardFeatures(board);
+    return w.height * f.aggregateHeight + w.holes * f.holes + w.bumpiness * f.bumpiness;
+}
+
+inline std::uint64_t hashBoard(const Board &board) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (RowMask r : board) {
+        h ^= r;
+        h *= 0x100000001b3ull;
+    }
+    return h ^ (h >> 29);
+}
+
+// A resting position for a piece, and the search state that reached it
+struct Placement {
+    Piece piece;
+    int state;
+};
+
+// Breadth-first search over (rotation, x, y) from a starting piece using the
+// engine's own move rules. Scratch space is reused between searches.
+class PlacementEnumerator {
+public:
+    // Appends every position where the piece can come to rest to out
+    void enumerate(const RowMask *board, const Piece &start, std::vector<Placement> &out) {
+        out.clear();
+        if (++stamp == 0) {
+            visited.fill(0);
+            stamp = 1;
+        }
+        startState = index(start);
+        if (startState < 0) return;
+        visited[startState] = stamp;
+        parent[startState] = -1;
+        int head = 0, tail = 0;
+        queue[tail++] = startState;
+
+        static constexpr Action moves[] = {Action::Left, Action::Right, Action::RotateCW, Action::RotateCCW, Action::SoftDrop};
+        while (head < tail) {
+            const int cur = queue[head++];
+            const Piece p = pieceAt(cur, start.kind);
+            Piece below = p;
+            ++below.y;
+            if (!rules::canPlace(board, below)) out.push_back(Placement{p, cur});
+
+            for (Action a : moves) {
+                PlayState s;
+                s.current = p;
+                switch (a) {
+                    case Action::Left: rules::moveHorizontal(board, s, -1); break;
+                    case Action::Right: rules::moveHorizontal(board, s, +1); break;
+                    case Action::RotateCW: rules::rotate(board, s, +1); break;
+                    case Action::RotateCCW: rules::rotate(board, s, -1); break;
+                    default:
+                        if (!rules::canPlace(board, below)) continue;
+                        s.current = below;
+                        break;
+                }
+                const int next = index(s.current);
+                if (next < 0 || visited[next] == stamp) continue;
+                visited[next] = stamp;
+                parent[next] = static_cast<std::int16_t>(cur);
+                via[next] = a;
+                queue[tail++] = static_cast<std::int16_t>(next);
+            }
+        }
+    }
+
+    // Inputs that take the start piece of the last search to placement p,
+    // ending with the hard drop that locks it
+    std::vector<Action> pathTo(const Placement &p) const {
+        std::vector<Action> path;
+        for (int s = p.state; s != startState; s = parent[s]) path.push_back(via[s]);
+        std::reverse(path.begin(), path.end());
+        path.push_back(Action::HardDrop);
+        return path;
+    }
+
+private:
+    static constexpr int X_OFFSET = 3;      // lowest legal x is -3
+    static constexpr int X_RANGE = COLS + 3;
+    static constexpr int Y_OFFSET = 4;      // garbage can lift a piece to y = -4, just above the board
+    static constexpr int Y_RANGE = ROWS + 4;
+    static constexpr int STATES = 4 * X_RANGE * Y_RANGE;
+
+    std::array<std::uint32_t, STATES> visited{};
+    std::array<std::int16_t, STATES> parent{};
+    std::array<Action, STATES> via{};
+    std::array<std::int16_t, STATES> queue{};
+    std::uint32_t stamp = 0;
+    int startState = 0;
+
+    // Search state of p, or -1 for a position no search can hold
+    static int index(const Piece &p) {
+        const int x = p.x + X_OFFSET, y = p.y + Y_OFFSET;
+        if (x < 0 || x >= X_RANGE || y < 0 || y >= Y_RANGE || p.rotation < 0 || p.rotation > 3) return -1;
+        return (p.rotation * Y_RANGE + y) * X_RANGE + x;
+    }
+
+    static Piece pieceAt(int state, int kind) {
+        Piece p;
+        p.kind = kind;
+        p.x = state % X_RANGE - X_OFFSET;
+        p.y = (state / X_RANGE) % Y_RANGE - Y_OFFSET;
+        p.rotation = state / (X_RANGE * Y_RANGE);
+        return p;
+    }
+};
+
+struct AiDecision {
+    std::vector<Action> actions; // inputs to apply, ending in a hard drop
+    bool found = false;
+    float value = 0.0f;
+    int depth = 0;               // pieces looked at, including the current one
+    double millis = 0.0;         // time spent deciding
+};
+
+struct AiOptions {
+    AiWeights weights;
+    int beamWidth = 48;
+    int maxDepth = 6;        // pieces, including the current one
+    double budgetMs = 45.0;  // comfortably inside a level-19 gravity tick; <= 0 means
+                             // no limit, so decisions depend only on the inputs
+    unsigned threads = 0;    // 0 = one per core
+};
+
+class TetrisAi {
+public:
+    explicit TetrisAi(const AiOptions &options = AiOptions())
+        : opt(options), pool(options.threads), enumerators(pool.size()), placements(pool.size()) {}
+
+    // Picks a placement for `current` on `board`. upcoming lists the kinds
+    // of the pieces that follow, as far as they are known.
+    AiDecision choose(const Board &board, const Piece &current, const int *upcoming, int upcomingCount) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                          std::chrono::duration<double, std::milli>(opt.budgetMs));
+        AiDecision decision;
+
+        // Depth 1: every placement of the current piece
+        rootSearch.enumerate(board.data(), current, rootPlacements);
+        beam.clear();
+        for (std::size_t i = 0; i < rootPlacements.size(); ++i) {
+            Node n;
+            n.board = board;
+            n.root = static_cast<int>(i);
+            n.reward = 0.0f;
+            place(n, rootPlacements[i].piece);
+            beam.push_back(n);
+        }
+        prune(beam);
+        if (beam.empty()) return decision;
+        int bestRoot = best(beam).root;
+        decision.value = best(beam).value;
+        decision.depth = 1;
+
+        // Deeper plies over the known upcoming pieces
+        const int depthLimit = std::min(opt.maxDepth - 1, upcomingCount);
+        for (int d = 0; d < depthLimit; ++d) {
+            const int kind = upcoming[d];
+            if (kind < 0) break;
+            std::atomic<bool> outOfTime{false};
+            if (children.size() < beam.size()) children.resize(beam.size());
+            pool.parallelFor(beam.size(), [&](std::size_t i, unsigned worker) {
+                if (outOfTime.load(std::memory_order_relaxed)) return;
+                if (opt.budgetMs > 0 && std::chrono::steady_clock::now() > deadline) {
+                    outOfTime = true;
+                    return;
+                }
+                expand(beam[i], kind, worker, children[i]);
+            });
+            if (outOfTime) break;
+
+            next.clear();
+            for (std::size_t i = 0; i < beam.size(); ++i) {
+                next.insert(next.end(), children[i].begin(), children[i].end());
+            }
+            prune(next);
+            if (next.empty()) break; // every line of play tops out
+            beam.swap(next);
+            bestRoot = best(beam).root;
+            decision.value = best(beam).value;
+            decision.depth = d + 2;
+        }
+
+        decision.actions = rootSearch.pathTo(rootPlacements[bestRoot]);
+        decision.found = true;
+        decision.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return decision;
+    }
+
+    const AiOptions &options() const { return opt; }
+    void setWeights(const AiWeights &w) { opt.weights = w; }
+
+private:
+    struct Node {
+        Board board;
+        float reward; // line-clear reward collected along the way
+        float value;  // reward plus the heuristic score of board
+        int root;     // which first placement this line of play started with
+    };
+
+    AiOptions opt;
+    TaskPool pool;
+    std::vector<PlacementEnumerator> enumerators;     // one per worker
+    std::vector<std::vector<Node>> children;          // one per beam node, merged in order
+    std::vector<std::vector<Placement>> placements;   // one per worker
+    PlacementEnumerator rootSearch;                   // kept intact to rebuild the path
+    std::vector<Placement> rootPlacements;
+    std::vector<Node> beam, next;
+
+    // Transposition table: open addressing from board hash to node index,
+    // emptied between plies by bumping the generation
+    std::vector<std::uint64_t> ttKeys;
+    std::vector<std::int32_t> ttIndex;
+    std::vector<std::uint32_t> ttStamp;
+    std::uint32_t ttGeneration = 0;
+
+    void place(Node &n, const Piece &p) const {
+        const PieceMask &m = PIECE_MASKS[p.kind][p.rotation];
+        const int left = p.x + m.minX;
+        for (int i = m.minY; i <= m.maxY; ++i) {
+            const int by = p.y + i;
+            if (by >= 0) n.board[by] = static_cast<RowMask>(n.board[by] | (m.rows[i] << left));
+        }
+        const int cleared = rules::clearFullRows(n.board.data(), nullptr, std::max(0, p.y + m.minY), std::max(0, p.y + m.maxY + 1));
+        n.reward += opt.weights.lines * cleared;
+        n.value = n.reward + evaluateBoard(n.board.data(), opt.weights);
+    }
+
+    void expand(const Node &parent, int kind, unsigned worker, std::vector<Node> &out) {
+        out.clear();
+        const Piece spawned = rules::spawnPiece(kind);
+        if (!rules::canPlace(parent.board.data(), spawned)) return; // tops out
+        std::vector<Placement> &found = placements[worker];
+        enumerators[worker].enumerate(parent.board.data(), spawned, found);
+        for (const Placement &p : found) {
+            Node child = parent;
+            place(child, p.piece);
+            out.push_back(child);
+        }
+    }
+
+    // Merges identical boards reached through different move orders, keeping
+    // the better one, then keeps the best beamWidth nodes
+    void prune(std::vector<Node> &nodes) {
+        std::size_t capacity = 64;
+        while (capacity < nodes.size() * 2) capacity <<= 1;
+        if (ttKeys.size() < capacity) {
+            ttKeys.assign(capacity, 0);
+            ttIndex.assign(capacity, 0);
+            ttStamp.assign(capacity, 0);
+            ttGeneration = 0;
+        }
+        if (++ttGeneration == 0) {
+            std::fill(ttStamp.begin(), ttStamp.end(), 0u);
+            ttGeneration = 1;
+        }
+        const std::size_t mask = ttKeys.size() - 1;
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            const std::uint64_t h = hashBoard(nodes[i].board);
+            std::size_t slot = h & mask;
+            bool duplicate = false;
+            while (ttStamp[slot] == ttGeneration) {
+                Node &other = nodes[ttIndex[slot]];
+                if (ttKeys[slot] == h && other.board == nodes[i].board) {
+                    if (nodes[i].value > other.value) other = nodes[i];
+                    duplicate = true;
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+            if (duplicate) continue;
+            if (kept != i) nodes[kept] = nodes[i];
+            ttStamp[slot] = ttGeneration;
+            ttKeys[slot] = h;
+            ttIndex[slot] = static_cast<std::int32_t>(kept);
+            ++kept;
+        }
+        nodes.resize(kept);
+
+        if (nodes.size() > static_cast<std::size_t>(opt.beamWidth)) {
+            std::nth_element(nodes.begin(), nodes.begin() + opt.beamWidth, nodes.end(),
+                             [](const Node &a, const Node &b) { return a.value > b.value; });
+            nodes.resize(opt.beamWidth);
+        }
+    }
+
+    static const Node &best(const std::vector<Node> &nodes) {
+        return *std::max_element(nodes.begin(), nodes.end(),
+                                 [](const Node &a, const Node &b) { return a.value < b.value; });
+    }
+};
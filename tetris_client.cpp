@@ -0,0 +1,276 @@
+// Load generator for tetris_server. Opens many connections from a single
+// epoll loop. Each one joins a match and sends random inputs at a fixed
+// rate, then joins again when the match ends. It reports how long the
+// server takes to echo an input's sequence number back in a STATE message.
+// Linux only.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "versus_protocol.hpp"
+
+using std::size_t;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+// Sent inputs remembered per connection for matching against STATE
+static constexpr int SENT_HISTORY = 64;
+static constexpr auto SEND_INTERVAL = std::chrono::milliseconds(5);
+
+struct ClientOptions {
+    std::string host = "127.0.0.1";
+    int port = 7777;
+    std::string unixPath;
+    int connections = 100;
+    double seconds = 10;
+    double inputRate = 10; // inputs per second per connection
+};
+
+struct Client {
+    int fd = -1;
+    vector<std::uint8_t> in, out;
+    bool inMatch = false;
+    std::uint16_t seq = 0;
+    Clock::time_point sentAt[SENT_HISTORY];
+    std::uint16_t ackedSeq = 0; // latest seq measured, so each input is counted once
+    Clock::time_point nextInput;
+};
+
+struct Totals {
+    std::uint64_t matches = 0, ended = 0, states = 0, inputs = 0, disconnects = 0;
+    vector<float> latencyMs;
+};
+
+static int connectTo(const ClientOptions &opt, const sockaddr_storage &addr, socklen_t len) {
+    const int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (opt.unixPath.empty()) {
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), len) != 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool resolve(const ClientOptions &opt, sockaddr_storage &addr, socklen_t &len) {
+    std::memset(&addr, 0, sizeof addr);
+    if (!opt.unixPath.empty()) {
+        sockaddr_un *un = reinterpret_cast<sockaddr_un *>(&addr);
+        if (opt.unixPath.size() >= sizeof un->sun_path) return false;
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, opt.unixPath.c_str(), opt.unixPath.size() + 1);
+        len = sizeof(sockaddr_un);
+        return true;
+    }
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(opt.host.c_str(), std::to_string(opt.port).c_str(), &hints, &res) != 0 || !res) return false;
+    std::memcpy(&addr, res->ai_addr, res->ai_addrlen);
+    len = res->ai_addrlen;
+    freeaddrinfo(res);
+    return true;
+}
+
+static void flush(Client &c) {
+    if (c.out.empty()) return;
+    const ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+    if (n > 0) c.out.erase(c.out.begin(), c.out.begin() + n);
+}
+
+// Handles whatever arrived; returns false once the server has hung up
+static bool readAll(Client &c, Totals &t, Clock::time_point now) {
+    std::uint8_t buf[16384];
+    for (;;) {
+        const ssize_t n = ::read(c.fd, buf, sizeof buf);
+        if (n > 0) {
+            c.in.insert(c.in.end(), buf, buf + n);
+            continue;
+        }
+        if (n == 0) return false;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+    }
+    size_t pos = 0;
+    while (pos < c.in.size()) {
+        const std::uint8_t *msg = &c.in[pos];
+        const size_t size = versus::messageSize(msg[0]);
+        if (size == 0) return false;
+        if (c.in.size() - pos < size) break;
+        if (msg[0] == versus::MSG_START) {
+            c.inMatch = true;
+            c.seq = c.ackedSeq = 0;
+            ++t.matches;
+        } else if (msg[0] == versus::MSG_STATE) {
+            ++t.states;
+            const std::uint16_t seq = static_cast<std::uint16_t>(versus::getLE(msg + 2, 2));
+            // Only our own board echoes our inputs
+            if (msg[1] == 0 && c.inMatch && seq != c.ackedSeq && static_cast<std::uint16_t>(c.seq - seq) < SENT_HISTORY) {
+                t.latencyMs.push_back(std::chrono::duration<float, std::milli>(now - c.sentAt[seq % SENT_HISTORY]).count());
+                c.ackedSeq = seq;
+            }
+        } else if (msg[0] == versus::MSG_END) {
+            c.inMatch = false;
+            ++t.ended;
+            versus::writeJoin(c.out);
+        }
+        pos += size;
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + static_cast<std::ptrdiff_t>(pos));
+    return true;
+}
+
+static float percentile(const vector<float> &sorted, double q) {
+    return sorted.empty() ? 0.f : sorted[static_cast<size_t>(q * (sorted.size() - 1))];
+}
+
+static void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--connect HOST:PORT | --unix PATH] [--connections N] [--seconds S] [--input-rate R]\n",
+                 argv0);
+}
+
+int main(int argc, char **argv) {
+    ClientOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--connect" && v) {
+            std::string target = argv[++i];
+            const size_t colon = target.rfind(':');
+            if (colon == std::string::npos) {
+                usage(argv[0]);
+                return 1;
+            }
+            opt.host = target.substr(0, colon);
+            opt.port = std::atoi(target.c_str() + colon + 1);
+        } else if (arg == "--unix" && v) opt.unixPath = argv[++i];
+        else if (arg == "--connections" && v) opt.connections = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && v) opt.seconds = std::atof(argv[++i]);
+        else if (arg == "--input-rate" && v) opt.inputRate = std::atof(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opt.connections < 1 || opt.inputRate <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    sockaddr_storage addr;
+    socklen_t addrLen = 0;
+    if (!resolve(opt, addr, addrLen)) {
+        std::fprintf(stderr, "cannot resolve server address\n");
+        return 1;
+    }
+    const int epoll = epoll_create1(0);
+    const int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    itimerspec spec{};
+    spec.it_interval.tv_nsec = static_cast<long>(std::chrono::nanoseconds(SEND_INTERVAL).count());
+    spec.it_value = spec.it_interval;
+    timerfd_settime(timer, 0, &spec, nullptr);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = ~0ull;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &ev);
+
+    std::mt19937 rng(12345);
+    const auto inputInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opt.inputRate));
+    vector<std::unique_ptr<Client>> clients;
+    const auto start = Clock::now();
+    for (int i = 0; i < opt.connections; ++i) {
+        auto c = std::make_unique<Client>();
+        c->fd = connectTo(opt, addr, addrLen);
+        if (c->fd < 0) {
+            std::fprintf(stderr, "connect failed after %d connections: %s\n", i, std::strerror(errno));
+            break;
+        }
+        // Spread the first inputs so connections do not send in lockstep
+        c->nextInput = start + std::chrono::duration_cast<Clock::duration>(inputInterval * (rng() % 1000 / 1000.0));
+        versus::writeJoin(c->out);
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = clients.size();
+        epoll_ctl(epoll, EPOLL_CTL_ADD, c->fd, &ev);
+        clients.push_back(std::move(c));
+    }
+
+    Totals t;
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.seconds));
+    epoll_event events[512];
+    while (Clock::now() < end) {
+        const int n = epoll_wait(epoll, events, 512, 50);
+        const auto now = Clock::now();
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == ~0ull) {
+                std::uint64_t expirations;
+                if (::read(timer, &expirations, sizeof expirations) < 0) continue;
+                // Send the inputs that are due, with one write per connection
+                for (auto &c : clients) {
+                    if (c->fd < 0) continue;
+                    while (c->inMatch && c->nextInput <= now) {
+                        ++c->seq;
+                        c->sentAt[c->seq % SENT_HISTORY] = now;
+                        const auto action = static_cast<Action>(1 + rng() % (static_cast<unsigned>(Action::Count) - 1));
+                        versus::writeInput(c->out, c->seq, action);
+                        c->nextInput += inputInterval;
+                        ++t.inputs;
+                    }
+                    if (!c->inMatch) c->nextInput = std::max(c->nextInput, now);
+                    flush(*c);
+                }
+                continue;
+            }
+            Client &c = *clients[events[i].data.u64];
+            if (c.fd < 0) continue;
+            if (!readAll(c, t, now) || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                ::close(c.fd);
+                c.fd = -1;
+                ++t.disconnects;
+                continue;
+            }
+            flush(c);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto &c : clients) {
+        if (c->fd >= 0) ::close(c->fd);
+    }
+    std::sort(t.latencyMs.begin(), t.latencyMs.end());
+    std::printf("connections=%zu matches=%llu ended=%llu disconnects=%llu inputs/s=%.0f states/s=%.0f\n",
+                clients.size(), static_cast<unsigned long long>(t.matches), static_cast<unsigned long long>(t.ended),
+                static_cast<unsigned long long>(t.disconnects), t.inputs / seconds, t.states / seconds);
+    std::printf("input->state latency ms: samples=%zu p50=%.2f p99=%.2f max=%.2f\n", t.latencyMs.size(),
+                percentile(t.latencyMs, 0.5), percentile(t.latencyMs, 0.99),
+                t.latencyMs.empty() ? 0.f : t.latencyMs.back());
+    ::close(timer);
+    ::close(epoll);
+    return 0;
+}
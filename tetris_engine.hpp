@@ -0,0 +1,913 @@
+// Headless Tetris rules shared by the SFML front end and the simulators.
+// Nothing in here touches SFML, windows or wall clocks: time only advances
+// when the caller ticks the engine.
+#pragma once
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "xoshiro.hpp"
+
+// Board configuration. The engine is a template over the board size; this
+// is the standard board, used wherever no other size is asked for.
+static constexpr int COLS = 10;
+static constexpr int ROWS = 20;
+
+// The engine advances in fixed ticks; gravity and timers are counted in ticks
+static constexpr int TICKS_PER_SECOND = 120;
+static constexpr float TICK_SECONDS = 1.0f / TICKS_PER_SECOND;
+
+// Gravity timings (seconds per cell); speeds up as level increases
+static constexpr float GRAVITY_LEVELS[] = {
+    0.8f, 0.7f, 0.6f, 0.5f, 0.4f, 0.35f, 0.3f, 0.25f, 0.20f, 0.18f,
+    0.16f, 0.14f, 0.12f, 0.10f, 0.09f, 0.08f, 0.075f, 0.07f, 0.065f, 0.06f
+};
+static constexpr int MAX_LEVEL = 19;
+
+static constexpr std::array<int, MAX_LEVEL + 1> makeGravityTicks() {
+    std::array<int, MAX_LEVEL + 1> ticks{};
+    for (int i = 0; i <= MAX_LEVEL; ++i) {
+        ticks[i] = static_cast<int>(GRAVITY_LEVELS[i] * TICKS_PER_SECOND + 0.5f);
+    }
+    return ticks;
+}
+
+// GRAVITY_LEVELS converted to whole ticks
+static constexpr auto GRAVITY_TICKS = makeGravityTicks();
+
+// Tetromino shapes defined as 4 rotation states × 4 cells (x,y)
+// Coordinates are in a 4x4 local grid
+struct Offset { int x; int y; };
+using PieceShape = std::array<std::array<Offset, 4>, 4>;
+
+// I, O, T, S, Z, J, L
+static constexpr std::array<PieceShape, 7> SHAPES = {
+    // I
+    PieceShape{ std::array<Offset, 4>{ Offset{0,1}, {1,1}, {2,1}, {3,1} },
+                std::array<Offset, 4>{ Offset{2,0}, {2,1}, {2,2}, {2,3} },
+                std::array<Offset, 4>{ Offset{0,2}, {1,2}, {2,2}, {3,2} },
+                std::array<Offset, 4>{ Offset{1,0}, {1,1}, {1,2}, {1,3} } },
+    // O
+    PieceShape{ std::array<Offset, 4>{ Offset{1,1}, {2,1}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {2,1}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {2,1}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {2,1}, {1,2}, {2,2} } },
+    // T
+    PieceShape{ std::array<Offset, 4>{ Offset{1,1}, {0,2}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {1,2}, {2,2}, {1,3} },
+                std::array<Offset, 4>{ Offset{0,2}, {1,2}, {2,2}, {1,3} },
+                std::array<Offset, 4>{ Offset{1,1}, {0,2}, {1,2}, {1,3} } },
+    // S
+    PieceShape{ std::array<Offset, 4>{ Offset{1,1}, {2,1}, {0,2}, {1,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {1,2}, {2,2}, {2,3} },
+                std::array<Offset, 4>{ Offset{1,2}, {2,2}, {0,3}, {1,3} },
+                std::array<Offset, 4>{ Offset{0,1}, {0,2}, {1,2}, {1,3} } },
+    // Z
+    PieceShape{ std::array<Offset, 4>{ Offset{0,1}, {1,1}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{2,1}, {1,2}, {2,2}, {1,3} },
+                std::array<Offset, 4>{ Offset{0,2}, {1,2}, {1,3}, {2,3} },
+                std::array<Offset, 4>{ Offset{1,1}, {0,2}, {1,2}, {0,3} } },
+    // J
+    PieceShape{ std::array<Offset, 4>{ Offset{0,1}, {0,2}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {2,1}, {1,2}, {1,3} },
+                std::array<Offset, 4>{ Offset{0,2}, {1,2}, {2,2}, {2,3} },
+                std::array<Offset, 4>{ Offset{1,1}, {1,2}, {0,3}, {1,3} } },
+    // L
+    PieceShape{ std::array<Offset, 4>{ Offset{2,1}, {0,2}, {1,2}, {2,2} },
+                std::array<Offset, 4>{ Offset{1,1}, {1,2}, {1,3}, {2,3} },
+                std::array<Offset, 4>{ Offset{0,2}, {1,2}, {2,2}, {0,3} },
+                std::array<Offset, 4>{ Offset{0,1}, {1,1}, {1,2}, {1,3} } }
+};
+
+// Board rows are bitmasks: bit c set means column c is occupied. Each board
+// width gets the narrowest mask that holds it, up to 64 columns.
+template <int Width>
+using BasicRowMask = std::conditional_t<Width <= 16, std::uint16_t,
+                                        std::conditional_t<Width <= 32, std::uint32_t, std::uint64_t>>;
+
+template <int Width>
+constexpr BasicRowMask<Width> fullRow() {
+    static_assert(Width >= 4 && Width <= 64, "boards are 4 to 64 columns wide");
+    using Mask = BasicRowMask<Width>;
+    if constexpr (Width == 8 * sizeof(Mask)) return static_cast<Mask>(~Mask{0});
+    else return static_cast<Mask>((Mask{1} << Width) - 1);
+}
+
+// Column heights and row numbers on a board this tall
+template <int Height>
+using StackHeight = std::conditional_t<Height <= 127, std::int8_t, std::int16_t>;
+
+// Per-board arrays. They are named through a struct so that the rules'
+// board size is never deduced from them and callers can pass nullptr.
+template <int Width, int Height>
+struct BoardArrays {
+    using Board = std::array<BasicRowMask<Width>, Height>;
+    using Colors = std::array<std::array<std::int8_t, Width>, Height>; // -1 empty, otherwise 0..6
+    // Stack height of each column: rows from the floor up to and including
+    // its topmost filled cell, 0 when the column is empty
+    using Heights = std::array<StackHeight<Height>, Width>;
+};
+
+template <int Width, int Height>
+using BasicBoard = typename BoardArrays<Width, Height>::Board;
+template <int Width, int Height>
+using BasicBoardColors = typename BoardArrays<Width, Height>::Colors;
+template <int Width, int Height>
+using BasicColumnHeights = typename BoardArrays<Width, Height>::Heights;
+
+// The standard board
+using RowMask = BasicRowMask<COLS>;
+static constexpr RowMask FULL_ROW = fullRow<COLS>();
+using Board = BasicBoard<COLS, ROWS>;
+using BoardColors = BasicBoardColors<COLS, ROWS>;
+using ColumnHeights = BasicColumnHeights<COLS, ROWS>;
+
+// One rotation of a piece as row masks. Bit 0 of each row is the piece's
+// leftmost local column (minX), so placing it is a single shift by x + minX.
+// Pieces are never wider than 4, so the masks are cast up to the board's
+// row type before they are shifted into place.
+struct PieceMask {
+    std::array<std::uint16_t, 4> rows;
+    int minX, maxX; // local column extents
+    int minY, maxY; // local row extents
+    std::array<int, 4> bottom; // lowest local row in each column, from minX
+};
+
+static constexpr PieceMask makePieceMask(const std::array<Offset, 4> &cells) {
+    PieceMask m{};
+    m.minX = m.minY = 3;
+    m.maxX = m.maxY = 0;
+    for (const auto &c : cells) {
+        m.minX = std::min(m.minX, c.x);
+        m.maxX = std::max(m.maxX, c.x);
+        m.minY = std::min(m.minY, c.y);
+        m.maxY = std::max(m.maxY, c.y);
+    }
+    for (const auto &c : cells) {
+        m.rows[c.y] = static_cast<std::uint16_t>(m.rows[c.y] | (1u << (c.x - m.minX)));
+        m.bottom[c.x - m.minX] = std::max(m.bottom[c.x - m.minX], c.y);
+    }
+    return m;
+}
+
+static constexpr std::array<std::array<PieceMask, 4>, 7> makePieceMasks() {
+    std::array<std::array<PieceMask, 4>, 7> masks{};
+    for (std::size_t k = 0; k < SHAPES.size(); ++k) {
+        for (std::size_t r = 0; r < 4; ++r) masks[k][r] = makePieceMask(SHAPES[k][r]);
+    }
+    return masks;
+}
+
+static constexpr auto PIECE_MASKS = makePieceMasks();
+static_assert(PIECE_MASKS[0][0].rows[1] == 0xF, "I piece spawn row should be four wide");
+
+struct Piece {
+    int kind;      // 0..6
+    int rotation;  // 0..3
+    int x;         // board column
+    int y;         // board row
+};
+
+// Seed for games that do not need to be reproduced from their seed alone
+inline std::uint64_t clockSeed() {
+    return static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+}
+
+// Fixed-layout copy of a RandomBag7, for snapshots
+struct BagState {
+    std::uint64_t rng[4];
+    std::int8_t queue[14];
+    std::uint8_t head, count;
+};
+
+// 7-bag randomizer with a queue of upcoming pieces. Whole bags are shuffled
+// into a ring ahead of time, so at least LOOKAHEAD pieces are always known.
+class RandomBag7 {
+public:
+    static constexpr int LOOKAHEAD = 7;
+
+    RandomBag7() : RandomBag7(clockSeed()) {}
+    explicit RandomBag7(std::uint64_t seed) : RandomBag7(Xoshiro256ss(seed)) {}
+    // Takes over a generator stream, e.g. one of several split with jump()
+    explicit RandomBag7(const Xoshiro256ss &stream) : rng(stream) {
+        refill();
+    }
+    int next() {
+        const int kind = queue[head];
+        head = (head + 1) % QUEUE_SIZE;
+        if (--count < LOOKAHEAD) refill();
+        return kind;
+    }
+    // What the (i+1)-th call to next() will return; always known for
+    // i < LOOKAHEAD, -1 beyond what has been shuffled so far
+    int peek(int i) const {
+        return i < count ? queue[(head + i) % QUEUE_SIZE] : -1;
+    }
+
+    void save(BagState &out) const {
+        rng.getState(out.rng);
+        for (int i = 0; i < QUEUE_SIZE; ++i) out.queue[i] = queue[i];
+        out.head = static_cast<std::uint8_t>(head);
+        out.count = static_cast<std::uint8_t>(count);
+    }
+    // Refuses, leaving the bag unchanged, a state no bag could be in
+    bool load(const BagState &in) {
+        if (in.head >= QUEUE_SIZE || in.count < LOOKAHEAD || in.count > QUEUE_SIZE) return false;
+        for (int i = 0; i < in.count; ++i) {
+            const int kind = in.queue[(in.head + i) % QUEUE_SIZE];
+            if (kind < 0 || kind > 6) return false;
+        }
+        Xoshiro256ss restored;
+        if (!restored.setState(in.rng)) return false;
+        rng = restored;
+        for (int i = 0; i < QUEUE_SIZE; ++i) queue[i] = in.queue[i];
+        head = in.head;
+        count = in.count;
+        return true;
+    }
+private:
+    static constexpr int QUEUE_SIZE = 2 * 7;
+    static_assert(sizeof(BagState::queue) == QUEUE_SIZE, "BagState must hold the whole queue");
+    Xoshiro256ss rng;
+    std::array<std::int8_t, QUEUE_SIZE> queue{};
+    int head = 0;
+    int count = 0;
+    // Appends one shuffled bag (Fisher-Yates)
+    void refill() {
+        std::array<std::int8_t, 7> bag = {0, 1, 2, 3, 4, 5, 6};
+        for (int i = 6; i > 0; --i) std::swap(bag[i], bag[rng.below(static_cast<std::uint32_t>(i + 1))]);
+        for (int i = 0; i < 7; ++i) queue[(head + count + i) % QUEUE_SIZE] = bag[i];
+        count += 7;
+    }
+};
+
+// BoardColors value of garbage cells sent by a versus opponent
+static constexpr std::int8_t GARBAGE_COLOR = 7;
+
+inline int scoreForClears(int count, int lvl) {
+    switch (count) {
+        case 1: return 40 * (lvl + 1);
+        case 2: return 100 * (lvl + 1);
+        case 3: return 300 * (lvl + 1);
+        case 4: return 1200 * (lvl + 1);
+        default: return 0;
+    }
+}
+
+// Player inputs understood by the engine
+enum class Action : std::uint8_t {
+    None,
+    Left,
+    Right,
+    RotateCW,
+    RotateCCW,
+    SoftDrop,
+    HardDrop,
+    Count
+};
+
+// Everything about a game except its board. Kept apart from the board so
+// TetrisBatch can store each field in its own array and share the rules.
+struct PlayState {
+    Piece current{};
+    int score = 0;
+    int linesCleared = 0;
+    int level = 0;
+    int gravityTicks = 0; // ticks since the last gravity step
+    int piecesSpawned = 0;
+    bool gameOver = false;
+};
+
+// The game rules as free functions over a board and its play state.
+// `colors` may be null when nobody is going to draw the board, and `heights`
+// when nobody needs fast drop distances. Every function takes the board size
+// as template arguments that default to the standard board, so
+// rules::canPlace(board, p) is the 10x20 game and rules::canPlace<64, 1000>
+// a wide one.
+namespace rules {
+
+// Index of the lowest set bit; m must not be zero
+template <typename Mask>
+inline int lowestBit(Mask m) {
+    return sizeof(Mask) > sizeof(unsigned) ? __builtin_ctzll(m) : __builtin_ctz(m);
+}
+
+#if defined(__SSE2__)
+// Rows in a 16-byte block that equal `pattern`, as one bit per row placed
+// at the row's first byte. SSE2 has no 64-bit compare, so 64-bit rows
+// compare as two 32-bit halves that must both match.
+template <typename Mask>
+inline unsigned matchedRows(__m128i block, __m128i pattern) {
+    __m128i eq;
+    if constexpr (sizeof(Mask) == 2) eq = _mm_cmpeq_epi16(block, pattern);
+    else if constexpr (sizeof(Mask) == 4) eq = _mm_cmpeq_epi32(block, pattern);
+    else {
+        eq = _mm_cmpeq_epi32(block, pattern);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+    constexpr unsigned firstBytes = sizeof(Mask) == 2 ? 0x5555u : sizeof(Mask) == 4 ? 0x1111u : 0x0101u;
+    return static_cast<unsigned>(_mm_movemask_epi8(eq)) & firstBytes;
+}
+
+template <typename Mask>
+inline __m128i broadcastRow(Mask m) {
+    if constexpr (sizeof(Mask) == 2) return _mm_set1_epi16(static_cast<short>(m));
+    else if constexpr (sizeof(Mask) == 4) return _mm_set1_epi32(static_cast<int>(m));
+    else return _mm_set1_epi64x(static_cast<long long>(m));
+}
+#endif
+
+// Boards at least this tall search for full rows with SIMD; on shorter ones
+// a plain loop over the rows is as fast
+static constexpr int SIMD_MIN_ROWS = 64;
+
+// Last full row in [first, end), or -1 when there is none. On tall boards
+// with SSE2, 16 bytes of rows are compared at a time, which is what keeps
+// clearing lines cheap on boards thousands of rows tall. Only scans of a
+// block or more take that path: whole-board clears, not lockPiece, which
+// checks just the four rows a piece covers. bench_engine checks it against
+// the plain loop before timing anything.
+template <int Width = COLS, int Height = ROWS>
+inline int findLastFullRow(const BasicRowMask<Width> *board, int first, int end) {
+    using Mask = BasicRowMask<Width>;
+    constexpr Mask full = fullRow<Width>();
+    int r = end;
+#if defined(__SSE2__)
+    if constexpr (Height >= SIMD_MIN_ROWS) {
+        constexpr int PER_BLOCK = 16 / sizeof(Mask);
+        const __m128i pattern = broadcastRow(full);
+        for (; r - PER_BLOCK >= first; r -= PER_BLOCK) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(board + r - PER_BLOCK));
+            const unsigned rows = matchedRows<Mask>(block, pattern);
+            if (rows) return r - PER_BLOCK + (31 - __builtin_clz(rows)) / static_cast<int>(sizeof(Mask));
+        }
+    }
+#endif
+    while (--r >= first) {
+        if (board[r] == full) return r;
+    }
+    return -1;
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline bool canPlace(const BasicRowMask<Width> *board, const Piece &p) {
+    using Mask = BasicRowMask<Width>;
+    const PieceMask &m = PIECE_MASKS[p.kind][p.rotation];
+    const int left = p.x + m.minX;
+    if (left < 0 || p.x + m.maxX >= Width || p.y + m.maxY >= Height) return false;
+    for (int i = m.minY; i <= m.maxY; ++i) {
+        const int by = p.y + i;
+        if (by >= 0 && (board[by] & (static_cast<Mask>(m.rows[i]) << left))) return false;
+    }
+    return true;
+}
+
+// Number of rows the piece can fall before it lands
+template <int Width = COLS, int Height = ROWS>
+inline int dropDistance(const BasicRowMask<Width> *board, const Piece &p) {
+    Piece next = p;
+    int dist = 0;
+    while (true) {
+        ++next.y;
+        if (!canPlace<Width, Height>(board, next)) return dist;
+        ++dist;
+    }
+}
+
+// Drop distance from the column heights alone, in constant time. Exact
+// whenever the piece is above the stack in every column it covers; a piece
+// tucked under an overhang falls back to the row-by-row search.
+template <int Width = COLS, int Height = ROWS>
+inline int dropDistance(const BasicRowMask<Width> *board, const BasicColumnHeights<Width, Height> &heights,
+                        const Piece &p) {
+    const PieceMask &m = PIECE_MASKS[p.kind][p.rotation];
+    const int left = p.x + m.minX;
+    int dist = Height;
+    for (int c = 0; c <= m.maxX - m.minX; ++c) {
+        const int room = Height - 1 - heights[left + c] - (p.y + m.bottom[c]);
+        if (room < 0) return dropDistance<Width, Height>(board, p);
+        dist = std::min(dist, room);
+    }
+    return dist;
+}
+
+// Rows above firstRow must be empty; passing the top of the stack saves
+// walking down through empty rows on tall boards
+template <int Width = COLS, int Height = ROWS>
+inline void computeHeights(const BasicRowMask<Width> *board, BasicColumnHeights<Width, Height> &heights,
+                           int firstRow = 0) {
+    using Mask = BasicRowMask<Width>;
+    constexpr Mask full = fullRow<Width>();
+    heights.fill(0);
+    Mask seen = 0;
+    for (int r = firstRow; r < Height && seen != full; ++r) {
+        Mask fresh = static_cast<Mask>(board[r] & ~seen & full);
+        seen = static_cast<Mask>(seen | board[r]);
+        for (; fresh; fresh &= fresh - 1) heights[lowestBit(fresh)] = static_cast<StackHeight<Height>>(Height - r);
+    }
+}
+
+// Removes the full rows among [first, end) and moves everything above them
+// down; rows from `end` on stay where they are. The rows between two full
+// ones move as one block, so the work is a memmove per cleared row rather
+// than a copy per surviving row. Returns how many rows were removed.
+template <int Width = COLS, int Height = ROWS>
+inline int clearFullRows(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors, int first, int end) {
+    using Mask = BasicRowMask<Width>;
+    int cleared = 0;
+    for (;;) {
+        const int full = findLastFullRow<Width, Height>(board, first, end);
+        const int start = full + 1; // everything above when no full row is left
+        if (cleared > 0 && end > start) {
+            std::memmove(board + start + cleared, board + start, (end - start) * sizeof(Mask));
+            if (colors) std::memmove(&(*colors)[start + cleared], &(*colors)[start], (end - start) * sizeof((*colors)[0]));
+        }
+        if (full < 0) break;
+        ++cleared;
+        end = full;
+    }
+    for (int r = 0; r < cleared; ++r) {
+        board[r] = 0;
+        if (colors) (*colors)[r].fill(-1);
+    }
+    return cleared;
+}
+
+// Removes full rows anywhere on the board
+template <int Width = COLS, int Height = ROWS>
+inline int clearFullRows(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors) {
+    return clearFullRows<Width, Height>(board, colors, 0, Height);
+}
+
+// Where a new piece of the given kind appears
+template <int Width = COLS, int Height = ROWS>
+inline Piece spawnPiece(int kind) {
+    return Piece{kind, 0, Width / 2 - 2, -1}; // spawn above visible area
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void spawnNewPiece(const BasicRowMask<Width> *board, RandomBag7 &bag, PlayState &s) {
+    s.current = spawnPiece<Width, Height>(bag.next());
+    ++s.piecesSpawned;
+    if (!canPlace<Width, Height>(board, s.current)) {
+        s.gameOver = true;
+    }
+    s.gravityTicks = 0;
+}
+
+// Writes the active piece into the board, clears lines and spawns the next
+// piece. Only the rows the piece covers can have filled up, so only those
+// are checked. Heights rise with the locked cells; after a clear they are
+// recomputed from the top of the stack down. Returns the number of lines cleared.
+template <int Width = COLS, int Height = ROWS>
+inline int lockPiece(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                     BasicColumnHeights<Width, Height> *heights, RandomBag7 &bag, PlayState &s) {
+    using Mask = BasicRowMask<Width>;
+    const Piece &p = s.current;
+    const PieceMask &m = PIECE_MASKS[p.kind][p.rotation];
+    const int left = p.x + m.minX;
+    for (int i = m.minY; i <= m.maxY; ++i) {
+        const int by = p.y + i;
+        if (by >= 0) board[by] = static_cast<Mask>(board[by] | (static_cast<Mask>(m.rows[i]) << left));
+    }
+    if (colors || heights) {
+        for (const auto &c : SHAPES[p.kind][p.rotation]) {
+            int by = p.y + c.y;
+            if (by < 0) continue;
+            if (colors) (*colors)[by][p.x + c.x] = static_cast<std::int8_t>(p.kind);
+            if (heights) {
+                StackHeight<Height> &h = (*heights)[p.x + c.x];
+                h = std::max(h, static_cast<StackHeight<Height>>(Height - by));
+            }
+        }
+    }
+
+    const int cleared = clearFullRows<Width, Height>(board, colors, std::max(0, p.y + m.minY), std::max(0, p.y + m.maxY + 1));
+    if (cleared > 0) {
+        if (heights) {
+            const int top = *std::max_element(heights->begin(), heights->end());
+            computeHeights<Width, Height>(board, *heights, Height - top);
+        }
+        s.linesCleared += cleared;
+        s.score += scoreForClears(cleared, s.level);
+        s.level = std::min(MAX_LEVEL, s.linesCleared / 10);
+    }
+    spawnNewPiece<Width, Height>(board, bag, s);
+    return cleared;
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void moveHorizontal(const BasicRowMask<Width> *board, PlayState &s, int dx) {
+    Piece moved = s.current;
+    moved.x += dx;
+    if (canPlace<Width, Height>(board, moved)) s.current = moved;
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void rotate(const BasicRowMask<Width> *board, PlayState &s, int dir) { // +1 CW, -1 CCW
+    Piece rotated = s.current;
+    rotated.rotation = (rotated.rotation + (dir > 0 ? 1 : 3)) % 4;
+
+    // Simple wall kicks: try small horizontal offsets
+    static constexpr int kicks[] = {0, -1, 1, -2, 2};
+    for (int k : kicks) {
+        Piece test = rotated;
+        test.x += k;
+        if (canPlace<Width, Height>(board, test)) { s.current = test; break; }
+    }
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void softDropStep(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                         BasicColumnHeights<Width, Height> *heights, RandomBag7 &bag, PlayState &s) {
+    Piece moved = s.current;
+    moved.y += 1;
+    if (canPlace<Width, Height>(board, moved)) {
+        s.current = moved;
+        s.score += 1; // soft drop point
+    } else {
+        lockPiece<Width, Height>(board, colors, heights, bag, s);
+    }
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void gravityStep(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                        BasicColumnHeights<Width, Height> *heights, RandomBag7 &bag, PlayState &s) {
+    Piece moved = s.current;
+    moved.y += 1;
+    if (canPlace<Width, Height>(board, moved)) {
+        s.current = moved;
+    } else {
+        lockPiece<Width, Height>(board, colors, heights, bag, s);
+    }
+    s.gravityTicks = 0;
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void hardDrop(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                     BasicColumnHeights<Width, Height> *heights, RandomBag7 &bag, PlayState &s) {
+    const int dist = heights ? dropDistance<Width, Height>(board, *heights, s.current)
+                             : dropDistance<Width, Height>(board, s.current);
+    s.current.y += dist;
+    s.score += dist * 2; // hard drop points
+    lockPiece<Width, Height>(board, colors, heights, bag, s);
+}
+
+template <int Width = COLS, int Height = ROWS>
+inline void apply(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                  BasicColumnHeights<Width, Height> *heights, RandomBag7 &bag, PlayState &s, Action a) {
+    if (s.gameOver) return;
+    switch (a) {
+        case Action::Left: moveHorizontal<Width, Height>(board, s, -1); break;
+        case Action::Right: moveHorizontal<Width, Height>(board, s, +1); break;
+        case Action::RotateCW: rotate<Width, Height>(board, s, +1); break;
+        case Action::RotateCCW: rotate<Width, Height>(board, s, -1); break;
+        case Action::SoftDrop: softDropStep<Width, Height>(board, colors, heights, bag, s); break;
+        case Action::HardDrop: hardDrop<Width, Height>(board, colors, heights, bag, s); break;
+        default: break;
+    }
+}
+
+// Pushes the stack up by `count` rows and fills the bottom with garbage
+// rows that are full except at holeColumn, clamped to the board. Blocks
+// pushed off the top end the game. The active piece rides up with the
+// stack if it would overlap.
+template <int Width = COLS, int Height = ROWS>
+inline void addGarbage(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                       BasicColumnHeights<Width, Height> *heights, PlayState &s, int count, int holeColumn) {
+    using Mask = BasicRowMask<Width>;
+    count = std::min(std::max(count, 0), Height);
+    holeColumn = std::min(std::max(holeColumn, 0), Width - 1);
+    if (count == 0) return;
+    bool overflow = false;
+    for (int r = 0; r < count; ++r) overflow |= board[r] != 0;
+    if (overflow) s.gameOver = true;
+    std::memmove(board, board + count, (Height - count) * sizeof(Mask));
+    if (colors) std::memmove(&(*colors)[0], &(*colors)[count], (Height - count) * sizeof((*colors)[0]));
+    const Mask garbage = static_cast<Mask>(fullRow<Width>() & ~(Mask{1} << holeColumn));
+    for (int r = Height - count; r < Height; ++r) {
+        board[r] = garbage;
+        if (colors) {
+            (*colors)[r].fill(GARBAGE_COLOR);
+            (*colors)[r][holeColumn] = -1;
+        }
+    }
+    if (heights && overflow) {
+        computeHeights<Width, Height>(board, *heights);
+    } else if (heights) {
+        for (int c = 0; c < Width; ++c) {
+            auto &h = (*heights)[c];
+            if (h > 0) h = static_cast<StackHeight<Height>>(h + count);
+            else if (c != holeColumn) h = static_cast<StackHeight<Height>>(count);
+        }
+    }
+    const PieceMask &m = PIECE_MASKS[s.current.kind][s.current.rotation];
+    while (!canPlace<Width, Height>(board, s.current)) --s.current.y;
+    if (s.current.y + m.maxY < 0) s.gameOver = true; // no room left on the board
+}
+
+// Advances gravity by one tick
+template <int Width = COLS, int Height = ROWS>
+inline void tick(BasicRowMask<Width> *board, BasicBoardColors<Width, Height> *colors,
+                 BasicColumnHeights<Width, Height> *heights, RandomBag7 &bag, PlayState &s) {
+    if (s.gameOver) return;
+    if (++s.gravityTicks >= GRAVITY_TICKS[s.level]) {
+        gravityStep<Width, Height>(board, colors, heights, bag, s);
+    }
+}
+
+} // namespace rules
+
+// A single game. Owns its board, colours and piece bag, and keeps the ghost
+// piece up to date for drawing. Column heights are tracked as pieces lock,
+// so the ghost costs a handful of operations however often it moves.
+template <int Width, int Height>
+class BasicTetrisEngine {
+public:
+    static constexpr int COLUMNS = Width, ROW_COUNT = Height;
+    using Mask = BasicRowMask<Width>;
+    using Board = BasicBoard<Width, Height>;
+    using BoardColors = BasicBoardColors<Width, Height>;
+    using ColumnHeights = BasicColumnHeights<Width, Height>;
+
+    // Everything needed to resume a game, in fixed-width fields with no
+    // pointers, so it copies with memcpy and goes to a file as it is. Column
+    // heights and the ghost are derived, and rebuilt by restore().
+    struct Snapshot {
+        std::uint16_t columns, rows;
+        std::int32_t kind, rotation, x, y;
+        std::int32_t score, lines, level, gravityTicks, pieces;
+        std::uint8_t gameOver;
+        std::uint64_t ticks;
+        BagState bag;
+        Board board;
+        BoardColors colors;
+    };
+    static_assert(std::is_trivially_copyable<Snapshot>::value, "snapshots are copied as bytes");
+
+    BasicTetrisEngine() { reset(); }
+    explicit BasicTetrisEngine(std::uint64_t seed) : bag(seed) { reset(); }
+
+    void reset() {
+        board.fill(0);
+        for (auto &row : colors) row.fill(-1);
+        heights.fill(0);
+        state = PlayState{};
+        ticks = 0;
+        rules::spawnNewPiece<Width, Height>(board.data(), bag, state);
+        updateGhost();
+    }
+
+    // Applies one input immediately, without advancing time
+    void apply(Action a) {
+        rules::apply<Width, Height>(board.data(), &colors, &heights, bag, state, a);
+        updateGhost();
+    }
+
+    // Advances the simulation by one tick (TICK_SECONDS)
+    void tick() {
+        rules::tick<Width, Height>(board.data(), &colors, &heights, bag, state);
+        ++ticks;
+        updateGhost();
+    }
+
+    // Applies an input and then advances one tick. Returns the score gained.
+    int step(Action a) {
+        const int before = state.score;
+        rules::apply<Width, Height>(board.data(), &colors, &heights, bag, state, a);
+        rules::tick<Width, Height>(board.data(), &colors, &heights, bag, state);
+        ++ticks;
+        updateGhost();
+        return state.score - before;
+    }
+
+    const Board &getBoard() const { return board; }
+    const BoardColors &getColors() const { return colors; }
+    const ColumnHeights &getHeights() const { return heights; }
+    const Piece &getCurrent() const { return state.current; }
+    const Piece &getGhost() const { return ghost; }
+    int getScore() const { return state.score; }
+    int getLevel() const { return state.level; }
+    int getLinesCleared() const { return state.linesCleared; }
+    int getPiecesSpawned() const { return state.piecesSpawned; }
+    // Ticks advanced since reset(), whether or not the game was still running
+    std::uint64_t getTick() const { return ticks; }
+    int getGravityTicks() const { return state.gravityTicks; }
+    bool isGameOver() const { return state.gameOver; }
+    // Kind of the i-th upcoming piece; known for i < RandomBag7::LOOKAHEAD
+    int peekNext(int i) const { return bag.peek(i); }
+
+    // Padding is zeroed, so equal games give byte-identical snapshots
+    Snapshot snapshot() const {
+        Snapshot s;
+        std::memset(&s, 0, sizeof s);
+        s.columns = Width;
+        s.rows = Height;
+        s.kind = state.current.kind;
+        s.rotation = state.current.rotation;
+        s.x = state.current.x;
+        s.y = state.current.y;
+        s.score = state.score;
+        s.lines = state.linesCleared;
+        s.level = state.level;
+        s.gravityTicks = state.gravityTicks;
+        s.pieces = state.piecesSpawned;
+        s.gameOver = state.gameOver;
+        s.ticks = ticks;
+        bag.save(s.bag);
+        s.board = board;
+        s.colors = colors;
+        return s;
+    }
+
+    // Resumes a game from snapshot(). Refuses, leaving this game unchanged,
+    // a snapshot of another board size or one no game could have produced.
+    bool restore(const Snapshot &s) {
+        if (s.columns != Width || s.rows != Height || s.kind < 0 || s.kind > 6 || s.rotation < 0 || s.rotation > 3 ||
+            s.score < 0 || s.lines < 0 || s.level < 0 || s.level > MAX_LEVEL || s.gravityTicks < 0 || s.pieces < 0) {
+            return false;
+        }
+        for (int r = 0; r < Height; ++r) {
+            for (int c = 0; c < Width; ++c) {
+                const bool filled = (s.board[r] >> c) & 1;
+                if (filled != (s.colors[r][c] >= 0) || s.colors[r][c] > GARBAGE_COLOR) return false;
+            }
+            if (s.board[r] & ~fullRow<Width>()) return false;
+        }
+        // Even a finished game keeps its piece between the walls and no higher
+        // than just above the board, where garbage can push it
+        const Piece current{s.kind, s.rotation, s.x, s.y};
+        const PieceMask &m = PIECE_MASKS[s.kind][s.rotation];
+        if (s.x + m.minX < 0 || s.x + m.maxX >= Width || s.y + m.maxY < -1 || s.y + m.maxY >= Height) return false;
+        if (!s.gameOver && !rules::canPlace<Width, Height>(s.board.data(), current)) return false;
+        RandomBag7 restoredBag = bag;
+        if (!restoredBag.load(s.bag)) return false;
+
+        board = s.board;
+        colors = s.colors;
+        bag = restoredBag;
+        state.current = current;
+        state.score = s.score;
+        state.linesCleared = s.lines;
+        state.level = s.level;
+        state.gravityTicks = s.gravityTicks;
+        state.piecesSpawned = s.pieces;
+        state.gameOver = s.gameOver != 0;
+        ticks = s.ticks;
+        rules::computeHeights<Width, Height>(board.data(), heights);
+        if (state.gameOver) ghost = state.current; // the piece may overlap the stack; it never drops again
+        else updateGhost();
+        return true;
+    }
+
+    // Versus garbage: see rules::addGarbage
+    void addGarbage(int count, int holeColumn) {
+        rules::addGarbage<Width, Height>(board.data(), &colors, &heights, state, count, holeColumn);
+        updateGhost();
+    }
+
+private:
+    Board board{};
+    BoardColors colors{};
+    ColumnHeights heights{};
+    PlayState state;
+    Piece ghost{};
+    RandomBag7 bag;
+    std::uint64_t ticks = 0;
+
+    void updateGhost() {
+        ghost = state.current;
+        ghost.y += rules::dropDistance<Width, Height>(board.data(), heights, ghost);
+    }
+};
+
+using TetrisEngine = BasicTetrisEngine<COLS, ROWS>;
+// Forking a game for a what-if search is a plain copy: the engine holds no
+// pointers or heap memory, so copying it is a memcpy of under a kilobyte
+static_assert(std::is_trivially_copyable<TetrisEngine>::value, "engines must copy as bytes");
+
+// N independent games advanced in lockstep. Every field lives in its own
+// array (structure of arrays) and boards are packed back to back, so a step
+// walks memory linearly and observations go straight into the caller's buffer.
+template <int Width, int Height>
+class BasicTetrisBatch {
+public:
+    using Mask = BasicRowMask<Width>;
+
+    // Words written per board by step(): Height row masks with the active
+    // piece drawn in, followed by the kind of the active piece.
+    static constexpr std::size_t OBSERVATION_WORDS = Height + 1;
+
+    // Board i draws its pieces from stream firstStream + i of the seed: the
+    // generator jumped that many times. Batches on different threads pass
+    // disjoint ranges of streams.
+    explicit BasicTetrisBatch(std::size_t count, std::uint64_t seed = 0, std::uint64_t firstStream = 0)
+        : count(count), boards(count * Height), kinds(count), rotations(count), xs(count), ys(count),
+          scores(count), lines(count), pieces(count), levels(count), gravityTicks(count), gameOver(count) {
+        Xoshiro256ss stream(seed);
+        for (std::uint64_t i = 0; i < firstStream; ++i) stream.jump();
+        bags.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            bags.emplace_back(stream);
+            stream.jump();
+        }
+        for (std::size_t i = 0; i < count; ++i) resetBoard(i);
+    }
+
+    std::size_t size() const { return count; }
+
+    // Applies actions[i] to board i and advances every board one tick.
+    // observations must hold size() * OBSERVATION_WORDS words. rewards and
+    // dones are optional. Finished boards are reset in place and flagged in
+    // dones for that step.
+    void step(const Action *actions, Mask *observations, std::int32_t *rewards = nullptr, std::uint8_t *dones = nullptr) {
+        for (std::size_t i = 0; i < count; ++i) {
+            Mask *board = &boards[i * Height];
+            PlayState s = load(i);
+            const int before = s.score;
+            rules::apply<Width, Height>(board, nullptr, nullptr, bags[i], s, actions[i]);
+            rules::tick<Width, Height>(board, nullptr, nullptr, bags[i], s);
+            if (rewards) rewards[i] = s.score - before;
+            if (dones) dones[i] = s.gameOver ? 1 : 0;
+            if (s.gameOver) {
+                ++gamesFinished;
+                resetBoard(i);
+                s = load(i);
+            } else {
+                store(i, s);
+            }
+            writeObservation(board, s.current, observations + i * OBSERVATION_WORDS);
+        }
+    }
+
+    const Mask *board(std::size_t i) const { return &boards[i * Height]; }
+    int score(std::size_t i) const { return scores[i]; }
+    int linesCleared(std::size_t i) const { return lines[i]; }
+    std::uint64_t finishedGames() const { return gamesFinished; }
+
+private:
+    std::size_t count;
+    std::vector<Mask> boards;
+    std::vector<std::int8_t> kinds, rotations, xs;
+    std::vector<StackHeight<Height>> ys;
+    std::vector<std::int32_t> scores, lines, pieces;
+    std::vector<std::uint8_t> levels;
+    std::vector<std::uint16_t> gravityTicks;
+    std::vector<std::uint8_t> gameOver;
+    std::vector<RandomBag7> bags;
+    std::uint64_t gamesFinished = 0;
+
+    PlayState load(std::size_t i) const {
+        PlayState s;
+        s.current = Piece{kinds[i], rotations[i], xs[i], ys[i]};
+        s.score = scores[i];
+        s.linesCleared = lines[i];
+        s.piecesSpawned = pieces[i];
+        s.level = levels[i];
+        s.gravityTicks = gravityTicks[i];
+        s.gameOver = gameOver[i] != 0;
+        return s;
+    }
+
+    void store(std::size_t i, const PlayState &s) {
+        kinds[i] = static_cast<std::int8_t>(s.current.kind);
+        rotations[i] = static_cast<std::int8_t>(s.current.rotation);
+        xs[i] = static_cast<std::int8_t>(s.current.x);
+        ys[i] = static_cast<StackHeight<Height>>(s.current.y);
+        scores[i] = s.score;
+        lines[i] = s.linesCleared;
+        pieces[i] = s.piecesSpawned;
+        levels[i] = static_cast<std::uint8_t>(s.level);
+        gravityTicks[i] = static_cast<std::uint16_t>(s.gravityTicks);
+        gameOver[i] = s.gameOver ? 1 : 0;
+    }
+
+    void resetBoard(std::size_t i) {
+        Mask *board = &boards[i * Height];
+        std::fill(board, board + Height, Mask{0});
+        PlayState s;
+        rules::spawnNewPiece<Width, Height>(board, bags[i], s);
+        store(i, s);
+    }
+
+    static void writeObservation(const Mask *board, const Piece &p, Mask *out) {
+        std::copy(board, board + Height, out);
+        const PieceMask &m = PIECE_MASKS[p.kind][p.rotation];
+        const int left = p.x + m.minX;
+        for (int i = m.minY; i <= m.maxY; ++i) {
+            const int by = p.y + i;
+            if (by >= 0) out[by] = static_cast<Mask>(out[by] | (static_cast<Mask>(m.rows[i]) << left));
+        }
+        out[Height] = static_cast<Mask>(p.kind);
+    }
+};
+
+using TetrisBatch = BasicTetrisBatch<COLS, ROWS>;
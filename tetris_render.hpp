@@ -0,0 +1,305 @@
+// Drawing for the Tetris window: layout, the playfield renderer and the side
+// panel. Kept out of tetris.cpp so they can be driven without a game loop,
+// e.g. by the draw benchmarks rendering offscreen.
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include "tetris_engine.hpp"
+
+// Window configuration
+static constexpr int CELL_SIZE = 28;
+static constexpr int SIDE_PANEL_WIDTH = 200;
+static constexpr int MARGIN = 10;
+static constexpr int WINDOW_WIDTH = COLS * CELL_SIZE + SIDE_PANEL_WIDTH + MARGIN * 3;
+static constexpr int WINDOW_HEIGHT = ROWS * CELL_SIZE + MARGIN * 2;
+
+// Indexed by BoardColors value: the piece kinds, then GARBAGE_COLOR
+static const std::array<sf::Color, 8> COLORS = {
+    sf::Color(0, 240, 240),   // I - cyan
+    sf::Color(240, 240, 0),   // O - yellow
+    sf::Color(160, 0, 240),   // T - purple
+    sf::Color(0, 240, 0),     // S - green
+    sf::Color(240, 0, 0),     // Z - red
+    sf::Color(0, 0, 240),     // J - blue
+    sf::Color(240, 160, 0),   // L - orange
+    sf::Color(120, 120, 120)  // garbage - grey
+};
+
+// Draws the playfield (frame, grid, locked cells, ghost and active piece)
+// from one persistent vertex array in a single draw call. Every cell owns
+// two quads, an outline and an inset fill; only cells whose contents changed
+// since the last frame have their vertex colours rewritten. The active piece
+// has quads of its own at the end so it can be drawn between grid cells.
+class BoardRenderer {
+public:
+    BoardRenderer() : vertices(sf::Quads, (FRAME_QUADS + ROWS * COLS * 2 + ACTIVE_QUADS) * 4) {
+        setQuad(0, MARGIN - 2.f, MARGIN - 2.f, COLS * CELL_SIZE + 4.f, ROWS * CELL_SIZE + 4.f, sf::Color(90, 90, 90));
+        setQuad(1, MARGIN, MARGIN, COLS * CELL_SIZE, ROWS * CELL_SIZE, sf::Color(30, 30, 30));
+        for (int r = 0; r < ROWS; ++r) {
+            for (int c = 0; c < COLS; ++c) {
+                const float x = static_cast<float>(MARGIN + c * CELL_SIZE);
+                const float y = static_cast<float>(MARGIN + r * CELL_SIZE);
+                const std::size_t q = cellQuad(r, c);
+                setQuad(q, x, y, CELL_SIZE, CELL_SIZE, sf::Color());
+                setQuad(q + 1, x + 1, y + 1, CELL_SIZE - 2, CELL_SIZE - 2, sf::Color());
+            }
+        }
+        shown.fill(INVALID);
+    }
+
+    // Brings the vertex colours in line with the engine and draws the active
+    // piece `alpha` of the way from `previous`, where it was a tick ago, to
+    // where it is now. Returns the number of cells that had to be rewritten.
+    int update(const TetrisEngine &engine, const Piece &previous, float alpha) {
+        const BoardColors &colors = engine.getColors();
+        std::array<std::uint8_t, ROWS * COLS> target;
+        for (int r = 0; r < ROWS; ++r) {
+            for (int c = 0; c < COLS; ++c) {
+                target[r * COLS + c] = colors[r][c] == -1 ? EMPTY : static_cast<std::uint8_t>(LOCKED + colors[r][c]);
+            }
+        }
+        stamp(target, engine.getGhost(), GHOST);
+        placeActive(engine.getCurrent(), previous, alpha);
+
+        int changed = 0;
+        for (int i = 0; i < ROWS * COLS; ++i) {
+            if (target[i] == shown[i]) continue;
+            shown[i] = target[i];
+            paintCell(i / COLS, i % COLS, target[i]);
+            ++changed;
+        }
+        return changed;
+    }
+
+    // Returns the number of draw calls issued
+    int draw(sf::RenderTarget &rt) const {
+        rt.draw(vertices);
+        return 1;
+    }
+
+private:
+    static constexpr std::size_t FRAME_QUADS = 2;
+    static constexpr std::size_t ACTIVE_QUADS = 4 * 2;
+    // Cell contents: EMPTY, or a base plus the piece kind
+    static constexpr std::uint8_t EMPTY = 0, LOCKED = 1, GHOST = 9, INVALID = 0xFF;
+
+    sf::VertexArray vertices;
+    std::array<std::uint8_t, ROWS * COLS> shown;
+
+    static std::size_t cellQuad(int r, int c) {
+        return FRAME_QUADS + static_cast<std::size_t>(r * COLS + c) * 2;
+    }
+
+    static void stamp(std::array<std::uint8_t, ROWS * COLS> &target, const Piece &p, std::uint8_t base) {
+        for (const auto &c : SHAPES[p.kind][p.rotation]) {
+            int gx = p.x + c.x;
+            int gy = p.y + c.y;
+            if (gy < 0) continue;
+            target[gy * COLS + gx] = static_cast<std::uint8_t>(base + p.kind);
+        }
+    }
+
+    void placeActive(const Piece &p, const Piece &previous, float alpha) {
+        float px = static_cast<float>(p.x);
+        float py = static_cast<float>(p.y);
+        if (previous.kind == p.kind && previous.rotation == p.rotation) {
+            px = previous.x + (p.x - previous.x) * alpha;
+            py = previous.y + (p.y - previous.y) * alpha;
+        }
+        std::size_t q = FRAME_QUADS + ROWS * COLS * 2;
+        for (const auto &c : SHAPES[p.kind][p.rotation]) {
+            const float cy = py + c.y;
+            // Cells still above the playfield are collapsed to nothing
+            const float size = cy < 0 ? 0.f : static_cast<float>(CELL_SIZE);
+            const float x = MARGIN + (px + c.x) * CELL_SIZE;
+            const float y = MARGIN + cy * CELL_SIZE;
+            setQuad(q, x, y, size, size, sf::Color(20, 20, 20));
+            setQuad(q + 1, x + 1, y + 1, std::max(size - 2, 0.f), std::max(size - 2, 0.f), COLORS[p.kind]);
+            q += 2;
+        }
+    }
+
+    void setQuad(std::size_t quad, float x, float y, float w, float h, sf::Color color) {
+        sf::Vertex *v = &vertices[quad * 4];
+        v[0].position = sf::Vector2f(x, y);
+        v[1].position = sf::Vector2f(x + w, y);
+        v[2].position = sf::Vector2f(x + w, y + h);
+        v[3].position = sf::Vector2f(x, y + h);
+        for (int i = 0; i < 4; ++i) v[i].color = color;
+    }
+
+    void setQuadColor(std::size_t quad, sf::Color color) {
+        sf::Vertex *v = &vertices[quad * 4];
+        for (int i = 0; i < 4; ++i) v[i].color = color;
+    }
+
+    void paintCell(int r, int c, std::uint8_t content) {
+        const sf::Color background(30, 30, 30);
+        const sf::Color emptyFill(40, 40, 40);
+        sf::Color outline = background;
+        sf::Color fill = emptyFill;
+        if (content >= GHOST) {
+            // Ghost cells are the piece colour at alpha 60 over an empty cell,
+            // blended here so the quad itself stays opaque
+            const sf::Color &tint = COLORS[content - GHOST];
+            auto blend = [](sf::Uint8 over, sf::Uint8 under) {
+                return static_cast<sf::Uint8>(under + (over - under) * 60 / 255);
+            };
+            fill = sf::Color(blend(tint.r, emptyFill.r), blend(tint.g, emptyFill.g), blend(tint.b, emptyFill.b));
+        } else if (content >= LOCKED) {
+            outline = sf::Color(20, 20, 20);
+            fill = COLORS[content - LOCKED];
+        }
+        const std::size_t q = cellQuad(r, c);
+        setQuadColor(q, outline);
+        setQuadColor(q + 1, fill);
+    }
+};
+
+inline sf::Text makeText(const sf::Font &font, const sf::String &s, float px, float py, unsigned size, sf::Color col, bool bold = false) {
+    sf::Text t;
+    t.setFont(font);
+    t.setString(s);
+    t.setCharacterSize(size);
+    t.setFillColor(col);
+    t.setPosition(px, py);
+    if (bold) t.setStyle(sf::Text::Bold);
+    return t;
+}
+
+// Side panel and pause / game-over overlays. Everything that never changes is
+// rendered once into textures; the score, level and line counters keep their
+// own sf::Text objects and are only re-laid-out when their values change.
+// The next-piece preview is one vertex array, rewritten when the queue moves.
+class SidePanel {
+public:
+    void init(const sf::Font &font) {
+        const float panelX = MARGIN * 2 + COLS * CELL_SIZE;
+        const float left = panelX + 16;
+
+        // Static panel: background, labels and controls
+        panelTexture.create(SIDE_PANEL_WIDTH + 4, ROWS * CELL_SIZE + 4);
+        panelTexture.clear(sf::Color::Transparent);
+        {
+            // Drawn in texture space, offset by the 2px outline
+            const float ox = panelX - 2, oy = MARGIN - 2;
+            sf::RectangleShape panel({static_cast<float>(SIDE_PANEL_WIDTH), static_cast<float>(ROWS * CELL_SIZE)});
+            panel.setPosition(2, 2);
+            panel.setFillColor(sf::Color(20, 20, 26));
+            panel.setOutlineThickness(2);
+            panel.setOutlineColor(sf::Color(90, 90, 90));
+            panelTexture.draw(panel);
+
+            auto label = [&](const sf::String &s, float py, unsigned size, sf::Color col, bool bold = false) {
+                panelTexture.draw(makeText(font, s, left - ox, py - oy, size, col, bold));
+            };
+            label("TETRIS", MARGIN + 10, 28, sf::Color::White, true);
+            label("Score:", MARGIN + 60, 18, sf::Color(200,200,200));
+            label("Level:", MARGIN + 120, 18, sf::Color(200,200,200));
+            label("Lines:", MARGIN + 180, 18, sf::Color(200,200,200));
+            label("Controls:", MARGIN + 250, 18, sf::Color(200,200,200));
+            label("←/→ Move", MARGIN + 272, 16, sf::Color(180,180,180));
+            label("↓ Soft Drop", MARGIN + 292, 16, sf::Color(180,180,180));
+            label("Space Hard Drop", MARGIN + 312, 16, sf::Color(180,180,180));
+            label("Z/X Rotate", MARGIN + 332, 16, sf::Color(180,180,180));
+            label("P Pause", MARGIN + 352, 16, sf::Color(180,180,180));
+            label("ESC Quit", MARGIN + 372, 16, sf::Color(180,180,180));
+            label("A Autopilot", MARGIN + 392, 16, sf::Color(180,180,180));
+            label("Next:", MARGIN + 418, 18, sf::Color(200,200,200));
+        }
+        panelTexture.display();
+        panelSprite.setTexture(panelTexture.getTexture(), true);
+        panelSprite.setPosition(panelX - 2, MARGIN - 2);
+
+        scoreText = makeText(font, "", left, MARGIN + 80, 24, sf::Color::White, true);
+        levelText = makeText(font, "", left, MARGIN + 140, 24, sf::Color::White, true);
+        linesText = makeText(font, "", left, MARGIN + 200, 24, sf::Color::White, true);
+        preview = sf::VertexArray(sf::Quads, PREVIEW_PIECES * 4 * 4);
+        shownNext.fill(-1);
+
+        renderOverlay(pausedTexture, sf::Color(0,0,0,120), {
+            makeText(font, "PAUSED", MARGIN + COLS*CELL_SIZE/2 - 60, WINDOW_HEIGHT/2 - 20, 36, sf::Color::Yellow, true)
+        });
+        renderOverlay(gameOverTexture, sf::Color(0,0,0,180), {
+            makeText(font, "GAME OVER", MARGIN + COLS*CELL_SIZE/2 - 100, WINDOW_HEIGHT/2 - 40, 40, sf::Color::Red, true),
+            makeText(font, "ESC to quit", MARGIN + COLS*CELL_SIZE/2 - 70, WINDOW_HEIGHT/2 + 10, 18, sf::Color(220,220,220))
+        });
+        pausedSprite.setTexture(pausedTexture.getTexture(), true);
+        gameOverSprite.setTexture(gameOverTexture.getTexture(), true);
+    }
+
+    // Marks the counters dirty when their values change
+    void update(int score, int level, int lines) {
+        refresh(scoreText, shownScore, score);
+        refresh(levelText, shownLevel, level);
+        refresh(linesText, shownLines, lines);
+    }
+
+    // Rewrites the preview quads of the upcoming pieces that changed
+    void updatePreview(const TetrisEngine &engine) {
+        for (int i = 0; i < PREVIEW_PIECES; ++i) {
+            const int kind = engine.peekNext(i);
+            if (kind == shownNext[i]) continue;
+            shownNext[i] = kind;
+            const float x0 = MARGIN * 2 + COLS * CELL_SIZE + 16.f;
+            const float y0 = MARGIN + 446.f + i * 36.f;
+            sf::Vertex *v = &preview[static_cast<std::size_t>(i) * 16];
+            for (const auto &c : SHAPES[kind][0]) {
+                // Rotation 0 occupies local rows 1 and 2
+                const float x = x0 + c.x * PREVIEW_CELL, y = y0 + (c.y - 1) * PREVIEW_CELL;
+                v[0].position = sf::Vector2f(x + 1, y + 1);
+                v[1].position = sf::Vector2f(x + PREVIEW_CELL - 1, y + 1);
+                v[2].position = sf::Vector2f(x + PREVIEW_CELL - 1, y + PREVIEW_CELL - 1);
+                v[3].position = sf::Vector2f(x + 1, y + PREVIEW_CELL - 1);
+                for (int k = 0; k < 4; ++k) v[k].color = COLORS[kind];
+                v += 4;
+            }
+        }
+    }
+
+    // The draw functions return the number of draw calls issued
+    int draw(sf::RenderTarget &rt) const {
+        rt.draw(panelSprite);
+        rt.draw(scoreText);
+        rt.draw(levelText);
+        rt.draw(linesText);
+        rt.draw(preview);
+        return 5;
+    }
+
+    int drawPausedOverlay(sf::RenderTarget &rt) const { rt.draw(pausedSprite); return 1; }
+    int drawGameOverOverlay(sf::RenderTarget &rt) const { rt.draw(gameOverSprite); return 1; }
+
+private:
+    sf::RenderTexture panelTexture, pausedTexture, gameOverTexture;
+    sf::Sprite panelSprite, pausedSprite, gameOverSprite;
+    sf::Text scoreText, levelText, linesText;
+    int shownScore = -1, shownLevel = -1, shownLines = -1;
+    // Upcoming pieces under "Next:", four quads each
+    static constexpr int PREVIEW_PIECES = 3;
+    static constexpr float PREVIEW_CELL = 16;
+    sf::VertexArray preview;
+    std::array<int, PREVIEW_PIECES> shownNext;
+
+    static void refresh(sf::Text &text, int &shown, int value) {
+        if (value == shown) return;
+        shown = value;
+        text.setString(std::to_string(value));
+    }
+
+    static void renderOverlay(sf::RenderTexture &texture, sf::Color shade, std::initializer_list<sf::Text> lines) {
+        texture.create(WINDOW_WIDTH, WINDOW_HEIGHT);
+        texture.clear(sf::Color::Transparent);
+        sf::RectangleShape overlay({static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT)});
+        overlay.setFillColor(shade);
+        texture.draw(overlay);
+        for (const sf::Text &t : lines) texture.draw(t);
+        texture.display();
+    }
+};
@@ -0,0 +1,299 @@
+// Replay files: the bag seed plus every input with the engine tick it was
+// applied on. Feeding the same inputs at the same ticks into a TetrisEngine
+// built from the same seed reproduces the game exactly.
+//
+// Layout (little-endian):
+//   "TRPL"  u16 version  u16 flags  u64 seed
+//   records: LEB128 varint of (ticks since previous record << 3 | code)
+//            code 1..6 is an Action, code 7 ends the input log
+//   after the end record: u32 score  u32 lines  u32 pieces  u8 gameOver
+// Most inputs fit in one byte.
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tetris_engine.hpp"
+#include "mapped_file.hpp"
+
+static constexpr char REPLAY_MAGIC[4] = {'T', 'R', 'P', 'L'};
+// Version 2: pieces come from xoshiro256** rather than std::mt19937
+static constexpr std::uint16_t REPLAY_VERSION = 2;
+static constexpr std::size_t REPLAY_HEADER_SIZE = 16;
+static constexpr std::size_t REPLAY_SUMMARY_SIZE = 13;
+static constexpr unsigned REPLAY_END_CODE = 7;
+static_assert(static_cast<unsigned>(Action::Count) <= REPLAY_END_CODE, "actions must fit in three bits");
+
+// Final state of a game, stored after the input log for verification
+struct ReplaySummary {
+    std::uint32_t score = 0;
+    std::uint32_t lines = 0;
+    std::uint32_t pieces = 0;
+    bool gameOver = false;
+
+    bool operator==(const ReplaySummary &o) const {
+        return score == o.score && lines == o.lines && pieces == o.pieces && gameOver == o.gameOver;
+    }
+    bool operator!=(const ReplaySummary &o) const { return !(*this == o); }
+};
+
+inline ReplaySummary summarize(const TetrisEngine &engine) {
+    ReplaySummary s;
+    s.score = static_cast<std::uint32_t>(engine.getScore());
+    s.lines = static_cast<std::uint32_t>(engine.getLinesCleared());
+    s.pieces = static_cast<std::uint32_t>(engine.getPiecesSpawned());
+    s.gameOver = engine.isGameOver();
+    return s;
+}
+
+// Records a game. Inputs are encoded into memory on the calling thread and
+// full buffers are handed to a background thread for writing, so record()
+// never waits on the disk.
+class ReplayWriter {
+public:
+    ~ReplayWriter() { close(); }
+
+    bool open(const std::string &path, std::uint64_t seed) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        buffer.clear();
+        buffer.reserve(FLUSH_BYTES * 2);
+        buffer.insert(buffer.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+        putLE(REPLAY_VERSION, 2);
+        putLE(0, 2);
+        putLE(seed, 8);
+        lastTick = 0;
+        stopping = false;
+        writer = std::thread([this] { writerLoop(); });
+        return true;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    void record(std::uint64_t tick, Action a) {
+        if (!file || a == Action::None) return;
+        putRecord(tick, static_cast<unsigned>(a));
+        if (buffer.size() >= FLUSH_BYTES) handOff();
+    }
+
+    // Ends the input log at `tick`, appends the summary and closes the file
+    void finish(std::uint64_t tick, const ReplaySummary &s) {
+        if (!file) return;
+        putRecord(tick, REPLAY_END_CODE);
+        putLE(s.score, 4);
+        putLE(s.lines, 4);
+        putLE(s.pieces, 4);
+        buffer.push_back(s.gameOver ? 1 : 0);
+        close();
+    }
+
+    // Flushes and closes. Without finish() the replay has no end record and
+    // is reported as truncated by ReplayReader.
+    void close() {
+        if (!file) return;
+        handOff();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+private:
+    static constexpr std::size_t FLUSH_BYTES = 4096;
+
+    std::FILE *file = nullptr;
+    std::vector<std::uint8_t> buffer;
+    std::deque<std::vector<std::uint8_t>> pending;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread writer;
+    bool stopping = false;
+    std::uint64_t lastTick = 0;
+
+    void putLE(std::uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i) buffer.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+    }
+
+    void putRecord(std::uint64_t tick, unsigned code) {
+        std::uint64_t v = ((tick - lastTick) << 3) | code;
+        lastTick = tick;
+        while (v >= 0x80) {
+            buffer.push_back(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        buffer.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    void handOff() {
+        if (buffer.empty()) return;
+        std::vector<std::uint8_t> full;
+        full.reserve(FLUSH_BYTES * 2);
+        full.swap(buffer);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(full));
+        }
+        wake.notify_one();
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            while (!pending.empty()) {
+                std::vector<std::uint8_t> chunk = std::move(pending.front());
+                pending.pop_front();
+                lock.unlock();
+                std::fwrite(chunk.data(), 1, chunk.size(), file);
+                lock.lock();
+            }
+            if (stopping) return;
+        }
+    }
+};
+
+// Walks a memory-mapped replay without copying it
+class ReplayReader {
+public:
+    // Maps the file and checks its header; error() says why on failure
+    bool open(const char *path) {
+        if (!map.open(path)) return fail("cannot open file");
+        if (map.size() < REPLAY_HEADER_SIZE || std::memcmp(map.data(), REPLAY_MAGIC, 4) != 0) {
+            return fail("not a replay file");
+        }
+        if (readLE(map.data() + 4, 2) != REPLAY_VERSION) return fail("unsupported replay version");
+        seedValue = readLE(map.data() + 8, 8);
+        pos = REPLAY_HEADER_SIZE;
+        tick = 0;
+        ended = false;
+        return true;
+    }
+
+    std::uint64_t seed() const { return seedValue; }
+
+    // Next input and the tick it was applied on. Returns false once the log
+    // ends; complete() then tells whether it ended properly.
+    bool next(std::uint64_t &atTick, Action &action) {
+        if (ended) return false;
+        std::uint64_t v = 0;
+        int shift = 0;
+        while (true) {
+            if (pos >= map.size() || shift > 63) {
+                fail("truncated input log");
+                ended = true;
+                return false;
+            }
+            const std::uint8_t b = map.data()[pos++];
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+            shift += 7;
+        }
+        tick += v >> 3;
+        const unsigned code = static_cast<unsigned>(v & 7);
+        if (code == REPLAY_END_CODE) {
+            ended = true;
+            if (map.size() - pos < REPLAY_SUMMARY_SIZE) {
+                fail("missing summary");
+                return false;
+            }
+            const unsigned char *p = map.data() + pos;
+            stored.score = static_cast<std::uint32_t>(readLE(p, 4));
+            stored.lines = static_cast<std::uint32_t>(readLE(p + 4, 4));
+            stored.pieces = static_cast<std::uint32_t>(readLE(p + 8, 4));
+            stored.gameOver = p[12] != 0;
+            hasSummary = true;
+            return false;
+        }
+        if (code == 0 || code >= static_cast<unsigned>(Action::Count)) {
+            fail("bad input code");
+            ended = true;
+            return false;
+        }
+        atTick = tick;
+        action = static_cast<Action>(code);
+        return true;
+    }
+
+    bool complete() const { return hasSummary; }
+    std::uint64_t endTick() const { return tick; }
+    const ReplaySummary &summary() const { return stored; }
+    const std::string &error() const { return message; }
+
+private:
+    MappedFile map;
+    std::size_t pos = 0;
+    std::uint64_t seedValue = 0;
+    std::uint64_t tick = 0;
+    bool ended = false;
+    bool hasSummary = false;
+    ReplaySummary stored;
+    std::string message;
+
+    bool fail(const char *why) {
+        message = why;
+        return false;
+    }
+
+    static std::uint64_t readLE(const unsigned char *p, int bytes) {
+        std::uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+        return v;
+    }
+};
+
+struct ReplayCheck {
+    bool ok = false;
+    std::string error;
+    ReplaySummary expected; // as stored in the file
+    ReplaySummary actual;   // after re-simulating
+    std::uint64_t ticks = 0;
+};
+
+// Re-simulates a replay as fast as possible, with no rendering, and compares
+// the outcome with the summary stored in the file
+inline ReplayCheck verifyReplay(const char *path) {
+    ReplayCheck check;
+    ReplayReader reader;
+    if (!reader.open(path)) {
+        check.error = reader.error();
+        return check;
+    }
+    TetrisEngine engine(reader.seed());
+    // A game left alone always ends, and no recorder ticks past the end, so
+    // a tick the game cannot reach marks a corrupt log; it must not be
+    // simulated, as a bad delta can lie some 2^60 ticks ahead
+    auto advanceTo = [&](std::uint64_t tick) {
+        while (engine.getTick() < tick && !engine.isGameOver()) engine.tick();
+        if (engine.getTick() == tick) return true;
+        check.error = "tick out of range";
+        return false;
+    };
+    std::uint64_t tick;
+    Action action;
+    while (reader.next(tick, action)) {
+        if (!advanceTo(tick)) return check;
+        engine.apply(action);
+    }
+    if (!reader.complete()) {
+        check.error = reader.error();
+        return check;
+    }
+    if (!advanceTo(reader.endTick())) return check;
+    check.ticks = engine.getTick();
+    check.expected = reader.summary();
+    check.actual = summarize(engine);
+    check.ok = check.expected == check.actual;
+    if (!check.ok) check.error = "outcome differs from recording";
+    return check;
+}
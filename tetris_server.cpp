@@ -0,0 +1,619 @@
+// Versus Tetris server. Clients connect over TCP or a Unix socket, send JOIN
+// and are paired into two-player matches; line clears send garbage rows to
+// the opponent. Every worker thread runs its own epoll loop. It accepts
+// connections from the shared listening sockets, owns the matches it
+// pairs, and steps them on a 120 Hz timer. Each match keeps its own tick
+// schedule, and no state is shared between workers. Linux only (epoll,
+// timerfd). See versus_protocol.hpp for the messages and tetris_client.cpp
+// for a load generator.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "tetris_engine.hpp"
+#include "versus_protocol.hpp"
+
+using std::size_t;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+// Garbage rows sent for clearing 0..4 lines at once, after cancelling any
+// garbage still waiting to be added to the sender's own board
+static constexpr int GARBAGE_FOR_CLEARS[] = {0, 0, 1, 2, 4};
+// Garbage rows added per locked piece at most; the rest waits for the next
+static constexpr int MAX_GARBAGE_PER_LOCK = 8;
+// A match this many ticks behind skips ahead instead of catching up, so one
+// slow wake-up cannot snowball into a long one
+static constexpr int MAX_CATCH_UP_TICKS = 8;
+// Inputs queued per player between ticks; further ones are dropped
+static constexpr size_t MAX_QUEUED_INPUTS = 32;
+// A client that lets this much output pile up is disconnected
+static constexpr size_t MAX_OUTPUT_BYTES = 256 * 1024;
+static constexpr auto TICK = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(TICK_SECONDS));
+
+static std::atomic<bool> stopRequested{false};
+
+struct ServerOptions {
+    int port = 7777;        // 0 = no TCP listener
+    std::string unixPath;   // Unix socket path, if any
+    unsigned threads = 0;   // 0 = one per core
+    double statsSeconds = 5;
+};
+
+// Figures a worker gathers between two stats reports
+struct WorkerStats {
+    size_t connections = 0, matches = 0;
+    std::uint64_t ticks = 0, messagesIn = 0, messagesOut = 0, bytesOut = 0, matchesFinished = 0;
+    vector<float> wakeMs; // time to step every due match, one sample per timer wake-up
+    float maxLateMs = 0;  // furthest any match tick ran behind its schedule
+};
+
+struct Match;
+
+struct Connection {
+    int fd = -1;
+    vector<std::uint8_t> in, out;
+    size_t outSent = 0;     // bytes of `out` already written
+    bool wantsWrite = false; // EPOLLOUT armed
+    bool queued = false;     // in the worker's flush list
+    bool closing = false;
+    Match *match = nullptr;
+    int player = -1;
+};
+
+struct Player {
+    TetrisEngine engine;
+    Connection *conn = nullptr; // null once disconnected
+    struct Input { std::uint16_t seq; Action action; };
+    vector<Input> inputs;      // received since the last tick
+    std::uint16_t lastSeq = 0;
+    int pendingGarbage = 0;
+    // What the clients were last told, to send only boards that changed
+    Piece sentPiece{};
+    int sentPieces = -1, sentGarbage = -1;
+    std::uint16_t sentSeq = 0;
+
+    explicit Player(std::uint64_t seed) : engine(seed) {}
+};
+
+struct Match {
+    std::uint32_t id;
+    std::uint64_t seed;
+    std::array<std::unique_ptr<Player>, 2> players;
+    Xoshiro256ss holes;         // garbage hole columns, shared by both boards
+    Clock::time_point nextTick; // when the next tick is due
+    std::uint32_t tick = 0;
+    bool over = false;
+
+    Match(std::uint32_t id, std::uint64_t seed) : id(id), seed(seed), holes(~seed) {
+        for (auto &p : players) p = std::make_unique<Player>(seed);
+    }
+};
+
+class Worker {
+public:
+    Worker(unsigned index, const vector<int> &listeners) : index(index), listeners(listeners) {}
+
+    ~Worker() {
+        for (auto &c : connections) ::close(c.first);
+        if (timer >= 0) ::close(timer);
+        if (epoll >= 0) ::close(epoll);
+    }
+
+    bool init() {
+        epoll = epoll_create1(0);
+        timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (epoll < 0 || timer < 0) return false;
+        itimerspec spec{};
+        spec.it_interval.tv_nsec = static_cast<long>(std::chrono::nanoseconds(TICK).count());
+        spec.it_value = spec.it_interval;
+        if (timerfd_settime(timer, 0, &spec, nullptr) != 0) return false;
+        if (!watch(timer, EPOLLIN, TIMER_TAG)) return false;
+        // EPOLLEXCLUSIVE wakes one worker per new connection rather than all
+        for (int fd : listeners) {
+            if (!watch(fd, EPOLLIN | EPOLLEXCLUSIVE, LISTEN_TAG | static_cast<std::uint64_t>(fd))) return false;
+        }
+        return true;
+    }
+
+    void run() {
+        epoll_event events[256];
+        while (!stopRequested) {
+            const int n = epoll_wait(epoll, events, 256, 100);
+            if (n < 0 && errno != EINTR) break;
+            for (int i = 0; i < n; ++i) {
+                const std::uint64_t tag = events[i].data.u64;
+                if (tag == TIMER_TAG) onTimer();
+                else if ((tag & TAG_MASK) == LISTEN_TAG) acceptAll(static_cast<int>(tag & ~TAG_MASK));
+                else onConnection(static_cast<int>(tag), events[i].events);
+            }
+            closePending();
+        }
+    }
+
+    // Hands over the figures published since the last call
+    WorkerStats takeStats() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        WorkerStats s = std::move(published);
+        published = WorkerStats();
+        return s;
+    }
+
+private:
+    static constexpr std::uint64_t TIMER_TAG = 1ull << 62, LISTEN_TAG = 1ull << 61, TAG_MASK = 3ull << 61;
+
+    unsigned index;
+    vector<int> listeners;
+    int epoll = -1, timer = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    vector<int> toClose;
+    vector<Connection *> toFlush;
+    Connection *waiting = nullptr; // joined and not yet paired
+    vector<std::unique_ptr<Match>> matches;
+    std::uint32_t nextMatchId = 0;
+    std::mt19937_64 seeds{std::random_device{}()};
+    Clock::time_point lastWake;
+    WorkerStats stats;     // only touched by this worker's thread
+    std::mutex statsMutex;
+    WorkerStats published; // stats handed over for the main thread, under statsMutex
+
+    void publishStats() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        published.connections = connections.size();
+        published.matches = matches.size();
+        published.ticks += stats.ticks;
+        published.messagesIn += stats.messagesIn;
+        published.messagesOut += stats.messagesOut;
+        published.bytesOut += stats.bytesOut;
+        published.matchesFinished += stats.matchesFinished;
+        published.maxLateMs = std::max(published.maxLateMs, stats.maxLateMs);
+        published.wakeMs.insert(published.wakeMs.end(), stats.wakeMs.begin(), stats.wakeMs.end());
+        stats = WorkerStats();
+    }
+
+    bool watch(int fd, std::uint32_t events, std::uint64_t tag) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = tag;
+        return epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    void acceptAll(int listener) {
+        for (;;) {
+            const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN, or another worker got there first
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one); // fails harmlessly on Unix sockets
+            if (!watch(fd, EPOLLIN | EPOLLRDHUP, static_cast<std::uint64_t>(fd))) {
+                ::close(fd);
+                continue;
+            }
+            auto c = std::make_unique<Connection>();
+            c->fd = fd;
+            connections.emplace(fd, std::move(c));
+        }
+    }
+
+    void onConnection(int fd, std::uint32_t events) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection &c = *it->second;
+        if (c.closing) return;
+        if (events & (EPOLLERR | EPOLLHUP)) return scheduleClose(c);
+        if (events & EPOLLOUT) flush(c);
+        if (events & (EPOLLIN | EPOLLRDHUP)) readAll(c);
+    }
+
+    void readAll(Connection &c) {
+        std::uint8_t buf[4096];
+        for (;;) {
+            const ssize_t n = ::read(c.fd, buf, sizeof buf);
+            if (n > 0) {
+                c.in.insert(c.in.end(), buf, buf + n);
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                scheduleClose(c);
+                return;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        }
+        size_t pos = 0;
+        while (pos < c.in.size()) {
+            const size_t size = versus::messageSize(c.in[pos]);
+            if (size == 0) return scheduleClose(c); // not speaking the protocol
+            if (c.in.size() - pos < size) break;
+            handleMessage(c, &c.in[pos]);
+            pos += size;
+            ++stats.messagesIn;
+        }
+        c.in.erase(c.in.begin(), c.in.begin() + static_cast<std::ptrdiff_t>(pos));
+    }
+
+    void handleMessage(Connection &c, const std::uint8_t *msg) {
+        if (msg[0] == versus::MSG_JOIN) {
+            if (c.match || waiting == &c) return;
+            if (!waiting) {
+                waiting = &c;
+                return;
+            }
+            startMatch(*waiting, c);
+            waiting = nullptr;
+        } else if (msg[0] == versus::MSG_INPUT && c.match) {
+            Player &p = *c.match->players[c.player];
+            const std::uint8_t action = msg[3];
+            if (action == 0 || action >= static_cast<std::uint8_t>(Action::Count)) return;
+            if (p.inputs.size() < MAX_QUEUED_INPUTS) {
+                p.inputs.push_back({static_cast<std::uint16_t>(versus::getLE(msg + 1, 2)), static_cast<Action>(action)});
+            }
+        }
+    }
+
+    void startMatch(Connection &a, Connection &b) {
+        const std::uint32_t id = (nextMatchId++ << 8) | index;
+        const std::uint64_t seed = seeds();
+        auto m = std::make_unique<Match>(id, seed);
+        // Tick on the worker's timer phase, so lateness measures real delay
+        m->nextTick = (lastWake == Clock::time_point() ? Clock::now() : lastWake) + TICK;
+        Connection *conns[2] = {&a, &b};
+        for (int i = 0; i < 2; ++i) {
+            m->players[i]->conn = conns[i];
+            conns[i]->match = m.get();
+            conns[i]->player = i;
+            versus::writeStart(conns[i]->out, id, seed, static_cast<std::uint8_t>(i));
+            queueFlush(*conns[i]);
+        }
+        for (int i = 0; i < 2; ++i) sendState(*m, i);
+        matches.push_back(std::move(m));
+    }
+
+    // Steps every match whose ticks have come due, then writes what they produced
+    void onTimer() {
+        std::uint64_t expirations;
+        if (::read(timer, &expirations, sizeof expirations) < 0) return;
+        const Clock::time_point start = Clock::now();
+        lastWake = start;
+        float maxLateMs = 0;
+        std::uint64_t ticks = 0;
+        for (size_t i = 0; i < matches.size();) {
+            Match &m = *matches[i];
+            const auto late = start - m.nextTick;
+            if (late > TICK * MAX_CATCH_UP_TICKS) m.nextTick = start - TICK * MAX_CATCH_UP_TICKS;
+            if (late > Clock::duration::zero()) {
+                maxLateMs = std::max(maxLateMs, std::chrono::duration<float, std::milli>(late).count());
+            }
+            while (!m.over && m.nextTick <= start) {
+                stepMatch(m);
+                m.nextTick += TICK;
+                ++ticks;
+            }
+            if (m.over) {
+                finishMatch(m);
+                matches[i] = std::move(matches.back());
+                matches.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        flushQueued();
+        stats.ticks += ticks;
+        stats.wakeMs.push_back(std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+        stats.maxLateMs = std::max(stats.maxLateMs, maxLateMs);
+        publishStats();
+    }
+
+    void stepMatch(Match &m) {
+        for (int i = 0; i < 2; ++i) {
+            Player &p = *m.players[i];
+            const int piecesBefore = p.engine.getPiecesSpawned();
+            const int linesBefore = p.engine.getLinesCleared();
+            for (const Player::Input &in : p.inputs) {
+                p.engine.apply(in.action);
+                p.lastSeq = in.seq;
+            }
+            p.inputs.clear();
+            p.engine.tick();
+            if (p.engine.getPiecesSpawned() == piecesBefore) continue;
+
+            // A piece locked: clears attack the opponent, otherwise garbage lands
+            const int cleared = p.engine.getLinesCleared() - linesBefore;
+            if (cleared > 0) {
+                int attack = GARBAGE_FOR_CLEARS[std::min(cleared, 4)];
+                const int cancelled = std::min(attack, p.pendingGarbage);
+                p.pendingGarbage -= cancelled;
+                m.players[1 - i]->pendingGarbage += attack - cancelled;
+            } else if (p.pendingGarbage > 0) {
+                const int rows = std::min(p.pendingGarbage, MAX_GARBAGE_PER_LOCK);
+                p.engine.addGarbage(rows, static_cast<int>(m.holes.below(COLS)));
+                p.pendingGarbage -= rows;
+            }
+        }
+        ++m.tick;
+        for (int i = 0; i < 2; ++i) {
+            if (changed(*m.players[i])) sendState(m, i);
+        }
+        m.over = m.players[0]->engine.isGameOver() || m.players[1]->engine.isGameOver();
+    }
+
+    static bool changed(const Player &p) {
+        const Piece &c = p.engine.getCurrent();
+        return c.x != p.sentPiece.x || c.y != p.sentPiece.y || c.rotation != p.sentPiece.rotation ||
+               c.kind != p.sentPiece.kind || p.engine.getPiecesSpawned() != p.sentPieces ||
+               p.pendingGarbage != p.sentGarbage || p.lastSeq != p.sentSeq || p.engine.isGameOver();
+    }
+
+    // Tells both players about board i
+    void sendState(Match &m, int i) {
+        Player &p = *m.players[i];
+        versus::BoardState s;
+        s.lastSeq = p.lastSeq;
+        s.tick = m.tick;
+        s.current = p.engine.getCurrent();
+        s.score = static_cast<std::uint32_t>(p.engine.getScore());
+        s.lines = static_cast<std::uint16_t>(p.engine.getLinesCleared());
+        s.pendingGarbage = static_cast<std::uint8_t>(std::min(p.pendingGarbage, 255));
+        s.gameOver = p.engine.isGameOver();
+        s.rows = p.engine.getBoard();
+        for (int to = 0; to < 2; ++to) {
+            Connection *c = m.players[to]->conn;
+            if (!c) continue;
+            s.board = to == i ? 0 : 1;
+            versus::writeState(c->out, s);
+            queueFlush(*c);
+        }
+        p.sentPiece = s.current;
+        p.sentPieces = p.engine.getPiecesSpawned();
+        p.sentGarbage = p.pendingGarbage;
+        p.sentSeq = p.lastSeq;
+    }
+
+    void finishMatch(Match &m) {
+        const bool lost0 = m.players[0]->engine.isGameOver() || !m.players[0]->conn;
+        const bool lost1 = m.players[1]->engine.isGameOver() || !m.players[1]->conn;
+        for (int i = 0; i < 2; ++i) {
+            Connection *c = m.players[i]->conn;
+            if (!c) continue;
+            const bool lost = i == 0 ? lost0 : lost1, otherLost = i == 0 ? lost1 : lost0;
+            const versus::Result r = lost == otherLost ? versus::RESULT_DRAW : lost ? versus::RESULT_LOST : versus::RESULT_WON;
+            versus::writeEnd(c->out, r, m.tick);
+            c->match = nullptr;
+            c->player = -1;
+            queueFlush(*c);
+        }
+        ++stats.matchesFinished;
+    }
+
+    // Output is written once per timer wake-up, or on EPOLLOUT when the socket was full
+    void queueFlush(Connection &c) {
+        ++stats.messagesOut;
+        if (c.queued || c.wantsWrite) return;
+        c.queued = true;
+        toFlush.push_back(&c);
+    }
+
+    void flushQueued() {
+        for (Connection *c : toFlush) {
+            c->queued = false;
+            if (!c->closing) flush(*c);
+        }
+        toFlush.clear();
+    }
+
+    void flush(Connection &c) {
+        while (c.outSent < c.out.size()) {
+            const ssize_t n = ::send(c.fd, c.out.data() + c.outSent, c.out.size() - c.outSent, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.outSent += static_cast<size_t>(n);
+                stats.bytesOut += static_cast<std::uint64_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0 && errno == EINTR) continue;
+            return scheduleClose(c);
+        }
+        if (c.outSent == c.out.size()) {
+            c.out.clear();
+            c.outSent = 0;
+        } else if (c.out.size() - c.outSent > MAX_OUTPUT_BYTES) {
+            return scheduleClose(c);
+        }
+        const bool wantsWrite = !c.out.empty();
+        if (wantsWrite != c.wantsWrite) {
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLRDHUP | (wantsWrite ? EPOLLOUT : 0u);
+            ev.data.u64 = static_cast<std::uint64_t>(c.fd);
+            epoll_ctl(epoll, EPOLL_CTL_MOD, c.fd, &ev);
+            c.wantsWrite = wantsWrite;
+        }
+    }
+
+    void scheduleClose(Connection &c) {
+        if (c.closing) return;
+        c.closing = true;
+        toClose.push_back(c.fd);
+    }
+
+    // Closed connections forfeit their match; the opponent is told at the next tick
+    void closePending() {
+        for (int fd : toClose) {
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection *c = it->second.get();
+            if (waiting == c) waiting = nullptr;
+            if (c->match) {
+                c->match->players[c->player]->conn = nullptr;
+                c->match->over = true;
+            }
+            if (c->queued) toFlush.erase(std::remove(toFlush.begin(), toFlush.end(), c), toFlush.end());
+            ::close(fd);
+            connections.erase(it);
+        }
+        toClose.clear();
+    }
+};
+
+static int listenTcp(int port) {
+    const int fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    const int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof zero); // IPv4 clients too
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(static_cast<std::uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0 || listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenUnix(const std::string &path) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof addr.sun_path) {
+        ::close(fd);
+        return -1;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0 || listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Thousands of clients need more descriptors than the usual soft limit
+static void raiseFileLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void printStats(vector<WorkerStats> &all, double seconds) {
+    WorkerStats total;
+    for (WorkerStats &s : all) {
+        total.connections += s.connections;
+        total.matches += s.matches;
+        total.ticks += s.ticks;
+        total.messagesIn += s.messagesIn;
+        total.messagesOut += s.messagesOut;
+        total.bytesOut += s.bytesOut;
+        total.matchesFinished += s.matchesFinished;
+        total.maxLateMs = std::max(total.maxLateMs, s.maxLateMs);
+        total.wakeMs.insert(total.wakeMs.end(), s.wakeMs.begin(), s.wakeMs.end());
+    }
+    std::sort(total.wakeMs.begin(), total.wakeMs.end());
+    auto pct = [&](double q) { return total.wakeMs.empty() ? 0.f : total.wakeMs[static_cast<size_t>(q * (total.wakeMs.size() - 1))]; };
+    std::fprintf(stderr,
+                 "connections=%zu matches=%zu boards=%zu finished=%llu match-ticks/s=%.0f in/s=%.0f out/s=%.0f "
+                 "out-MB/s=%.2f wake-ms p50=%.3f p99=%.3f max=%.3f late-max-ms=%.2f\n",
+                 total.connections, total.matches, total.matches * 2,
+                 static_cast<unsigned long long>(total.matchesFinished), total.ticks / seconds,
+                 total.messagesIn / seconds, total.messagesOut / seconds, total.bytesOut / seconds / 1e6, pct(0.5),
+                 pct(0.99), total.wakeMs.empty() ? 0.f : total.wakeMs.back(), total.maxLateMs);
+}
+
+static void usage(const char *argv0) {
+    std::fprintf(stderr, "usage: %s [--port N] [--unix PATH] [--threads N] [--stats-seconds S]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    ServerOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--port" && v) opt.port = std::atoi(argv[++i]);
+        else if (arg == "--unix" && v) opt.unixPath = argv[++i];
+        else if (arg == "--threads" && v) opt.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--stats-seconds" && v) opt.statsSeconds = std::atof(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    raiseFileLimit();
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, [](int) { stopRequested = true; });
+    std::signal(SIGTERM, [](int) { stopRequested = true; });
+
+    vector<int> listeners;
+    if (opt.port > 0) {
+        const int fd = listenTcp(opt.port);
+        if (fd < 0) {
+            std::fprintf(stderr, "cannot listen on port %d: %s\n", opt.port, std::strerror(errno));
+            return 1;
+        }
+        listeners.push_back(fd);
+    }
+    if (!opt.unixPath.empty()) {
+        const int fd = listenUnix(opt.unixPath);
+        if (fd < 0) {
+            std::fprintf(stderr, "cannot listen on %s: %s\n", opt.unixPath.c_str(), std::strerror(errno));
+            return 1;
+        }
+        listeners.push_back(fd);
+    }
+    if (listeners.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    vector<std::unique_ptr<Worker>> workers;
+    vector<std::thread> running;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>(i, listeners));
+        if (!workers.back()->init()) {
+            std::fprintf(stderr, "cannot set up worker: %s\n", std::strerror(errno));
+            return 1;
+        }
+    }
+    for (auto &w : workers) running.emplace_back([&w] { w->run(); });
+    std::fprintf(stderr, "tetris_server: %u workers, port %d%s%s\n", threads, opt.port,
+                 opt.unixPath.empty() ? "" : ", unix ", opt.unixPath.c_str());
+
+    auto last = Clock::now();
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        const auto now = Clock::now();
+        const double seconds = std::chrono::duration<double>(now - last).count();
+        if (seconds < opt.statsSeconds) continue;
+        vector<WorkerStats> all;
+        for (auto &w : workers) all.push_back(w->takeStats());
+        printStats(all, seconds);
+        last = now;
+    }
+    for (auto &t : running) t.join();
+    for (int fd : listeners) ::close(fd);
+    if (!opt.unixPath.empty()) ::unlink(opt.unixPath.c_str());
+    return 0;
+}
@@ -0,0 +1,305 @@
+// Headless Tetris simulator. By default it drives TetrisBatch with a random
+// policy on every core and reports throughput; --ai plays full games with
+// the autopilot instead, --tournament and --optimize tune the autopilot's
+// weights with self-play, and --verify re-simulates recorded replays. Needs
+// no display and no SFML.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tetris_engine.hpp"
+#include "tetris_ai.hpp"
+#include "tetris_replay.hpp"
+#include "tetris_tournament.hpp"
+#include "thread_pool.hpp"
+
+using std::size_t;
+using std::vector;
+
+struct SimOptions {
+    size_t boards = 1024;    // boards per thread
+    long steps = 20000;      // batch steps per thread
+    int boardWidth = COLS, boardHeight = ROWS; // one of the BOARD_SIZES
+    unsigned threads = 0;    // 0 = one per core
+    unsigned seed = 1;
+    bool ai = false;
+    int games = 10;          // --ai: games to play
+    int maxPieces = 1000;    // --ai: stop a game after this many pieces
+    AiOptions aiOptions;
+    bool beamSet = false, depthSet = false;
+    std::string recordDir;   // --ai: write a replay per game here
+    bool tournament = false;
+    int generations = 0;     // --optimize: generations to run
+    int population = 16;     // --optimize: candidates per generation
+    int elite = 4;           // --optimize: candidates the next generation is fitted to
+    vector<AiWeights> weights; // --tournament candidates / --optimize starting point
+    vector<std::string> verify; // replays to re-simulate
+};
+
+// Tournament games use a much smaller search than the interactive autopilot
+// unless told otherwise; tuning needs many games more than strong ones
+static constexpr int TOURNAMENT_BEAM = 4;
+static constexpr int TOURNAMENT_DEPTH = 2;
+
+static void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--boards N] [--steps N] [--threads N] [--seed N] [--board 10x20|20x40|32x200|64x1000]\n"
+                 "       %s --ai [--games N] [--max-pieces N] [--beam N] [--depth N] [--budget-ms N] [--threads N] [--seed N] [--record-dir DIR]\n"
+                 "       %s --tournament [--weights H,L,HOLES,BUMP]... [--games N] [--max-pieces N] [--beam N] [--depth N] [--threads N] [--seed N]\n"
+                 "       %s --optimize GENERATIONS [--population N] [--elite N] [--weights H,L,HOLES,BUMP] [--games N] [--max-pieces N] [--beam N] [--depth N] [--threads N] [--seed N]\n"
+                 "       %s [--threads N] --verify REPLAY...\n",
+                 argv0, argv0, argv0, argv0, argv0);
+}
+
+// "H,L,HOLES,BUMP" in the order AiWeights declares them
+static bool parseWeights(const char *text, AiWeights &w) {
+    return std::sscanf(text, "%f,%f,%f,%f", &w.height, &w.lines, &w.holes, &w.bumpiness) == 4;
+}
+
+static bool parseArgs(int argc, char **argv, SimOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char *v = nullptr;
+        if (arg == "--boards" && (v = value())) opt.boards = std::strtoul(v, nullptr, 10);
+        else if (arg == "--steps" && (v = value())) opt.steps = std::strtol(v, nullptr, 10);
+        else if (arg == "--threads" && (v = value())) opt.threads = static_cast<unsigned>(std::strtoul(v, nullptr, 10));
+        else if (arg == "--seed" && (v = value())) opt.seed = static_cast<unsigned>(std::strtoul(v, nullptr, 10));
+        else if (arg == "--ai") opt.ai = true;
+        else if (arg == "--games" && (v = value())) opt.games = std::atoi(v);
+        else if (arg == "--max-pieces" && (v = value())) opt.maxPieces = std::atoi(v);
+        else if (arg == "--beam" && (v = value())) { opt.aiOptions.beamWidth = std::atoi(v); opt.beamSet = true; }
+        else if (arg == "--depth" && (v = value())) { opt.aiOptions.maxDepth = std::atoi(v); opt.depthSet = true; }
+        else if (arg == "--budget-ms" && (v = value())) opt.aiOptions.budgetMs = std::atof(v);
+        else if (arg == "--record-dir" && (v = value())) opt.recordDir = v;
+        else if (arg == "--board" && (v = value())) {
+            if (std::sscanf(v, "%dx%d", &opt.boardWidth, &opt.boardHeight) != 2) return false;
+        }
+        else if (arg == "--tournament") opt.tournament = true;
+        else if (arg == "--optimize" && (v = value())) opt.generations = std::atoi(v);
+        else if (arg == "--population" && (v = value())) opt.population = std::atoi(v);
+        else if (arg == "--elite" && (v = value())) opt.elite = std::atoi(v);
+        else if (arg == "--weights" && (v = value())) {
+            AiWeights w;
+            if (!parseWeights(v, w)) return false;
+            opt.weights.push_back(w);
+        }
+        else if (arg == "--verify") {
+            opt.verify.assign(argv + i + 1, argv + argc);
+            return !opt.verify.empty();
+        }
+        else return false;
+    }
+    return opt.boards > 0 && opt.steps > 0 && opt.games > 0 && opt.population > 0;
+}
+
+// Random policy biased towards moving and rotating, with the odd hard drop
+static Action randomAction(std::uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    static constexpr Action table[16] = {
+        Action::None, Action::None, Action::None, Action::None,
+        Action::Left, Action::Left, Action::Right, Action::Right,
+        Action::RotateCW, Action::RotateCW, Action::RotateCCW, Action::SoftDrop,
+        Action::SoftDrop, Action::SoftDrop, Action::None, Action::HardDrop
+    };
+    return table[state >> 28];
+}
+
+// Plays whole games with the autopilot, one after another, and reports
+// scores and how long each decision took
+static int runAiGames(const SimOptions &opt) {
+    AiOptions aiOptions = opt.aiOptions;
+    aiOptions.threads = opt.threads;
+    if (!opt.weights.empty()) aiOptions.weights = opt.weights.front();
+    TetrisAi ai(aiOptions);
+    vector<double> decisionMs;
+    long long totalScore = 0, totalLines = 0;
+    for (int g = 0; g < opt.games; ++g) {
+        const unsigned seed = opt.seed + static_cast<unsigned>(g);
+        ReplayWriter replay;
+        if (!opt.recordDir.empty()) {
+            std::string path = opt.recordDir + "/game-" + std::to_string(seed) + ".trp";
+            if (!replay.open(path, seed)) std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        }
+        const GameResult r = playAiGame(ai, seed, opt.maxPieces, &replay, &decisionMs);
+        totalScore += r.score;
+        totalLines += r.lines;
+        std::printf("game=%d seed=%u score=%d lines=%d level=%d pieces=%d%s\n", g, seed, r.score, r.lines,
+                    r.level, r.pieces, r.toppedOut ? " topped-out" : "");
+    }
+    if (decisionMs.empty()) return 0;
+    std::sort(decisionMs.begin(), decisionMs.end());
+    double sum = 0;
+    for (double ms : decisionMs) sum += ms;
+    std::printf("games=%d mean-score=%.0f mean-lines=%.1f decisions=%zu decision-ms mean=%.2f p99=%.2f max=%.2f\n",
+                opt.games, double(totalScore) / opt.games, double(totalLines) / opt.games, decisionMs.size(),
+                sum / decisionMs.size(), decisionMs[decisionMs.size() * 99 / 100], decisionMs.back());
+    return 0;
+}
+
+static AiOptions tournamentAiOptions(const SimOptions &opt) {
+    AiOptions o = opt.aiOptions;
+    if (!opt.beamSet) o.beamWidth = TOURNAMENT_BEAM;
+    if (!opt.depthSet) o.maxDepth = TOURNAMENT_DEPTH;
+    return o;
+}
+
+static vector<unsigned> seedRange(unsigned first, int count) {
+    vector<unsigned> seeds;
+    for (int i = 0; i < count; ++i) seeds.push_back(first + static_cast<unsigned>(i));
+    return seeds;
+}
+
+static void printStats(const char *label, const TournamentStats &s) {
+    std::printf("%s weights=%.4f,%.4f,%.4f,%.4f games=%d topped-out=%d\n", label, s.weights.height, s.weights.lines,
+                s.weights.holes, s.weights.bumpiness, s.games, s.toppedOut);
+    std::printf("  score mean=%.0f min=%d median=%d max=%d\n", s.meanScore, s.minScore, s.medianScore, s.maxScore);
+    std::printf("  lines mean=%.1f min=%d median=%d max=%d\n", s.meanLines, s.minLines, s.medianLines, s.maxLines);
+    std::printf("  final-level");
+    for (int l = 0; l <= MAX_LEVEL; ++l) {
+        if (s.levels[l]) std::printf(" %d:%d", l, s.levels[l]);
+    }
+    std::printf("\n");
+}
+
+// Plays every candidate weight vector on the same seeds and reports the
+// distribution of outcomes for each
+static int runTournament(const SimOptions &opt) {
+    vector<AiWeights> candidates = opt.weights;
+    if (candidates.empty()) candidates.push_back(AiWeights());
+    Tournament tournament(tournamentAiOptions(opt), opt.threads);
+    const vector<unsigned> seeds = seedRange(opt.seed, opt.games);
+    auto start = std::chrono::steady_clock::now();
+    const auto results = tournament.play(candidates, seeds, opt.maxPieces);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        printStats(("candidate=" + std::to_string(c)).c_str(), summarizeResults(candidates[c], results[c]));
+    }
+    std::printf("threads=%u games=%zu elapsed=%.2fs games/s=%.2f\n", tournament.threads(),
+                candidates.size() * seeds.size(), secs, candidates.size() * seeds.size() / secs);
+    return 0;
+}
+
+// Cross-entropy search over the weights. Each generation plays all its
+// candidates on a fresh set of seeds shared between them, so candidates are
+// compared on the same piece sequences; fitness is mean lines cleared.
+static int runOptimizer(const SimOptions &opt) {
+    CrossEntropyOptimizer optimizer(opt.weights.empty() ? AiWeights() : opt.weights.front(), 0.5f, opt.seed);
+    Tournament tournament(tournamentAiOptions(opt), opt.threads);
+    for (int gen = 0; gen < opt.generations; ++gen) {
+        const vector<AiWeights> population = optimizer.sample(opt.population);
+        const vector<unsigned> seeds = seedRange(opt.seed + static_cast<unsigned>(gen * opt.games), opt.games);
+        auto start = std::chrono::steady_clock::now();
+        const auto results = tournament.play(population, seeds, opt.maxPieces);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        vector<double> fitness;
+        size_t bestIndex = 0;
+        for (size_t c = 0; c < population.size(); ++c) {
+            fitness.push_back(summarizeResults(population[c], results[c]).meanLines);
+            if (fitness[c] > fitness[bestIndex]) bestIndex = c;
+        }
+        double meanFitness = 0;
+        for (double f : fitness) meanFitness += f / fitness.size();
+        optimizer.update(population, fitness, opt.elite);
+        const AiWeights &best = population[bestIndex];
+        const AiWeights mean = optimizer.current();
+        std::printf("gen=%d best-lines=%.1f mean-lines=%.1f best=%.4f,%.4f,%.4f,%.4f mean=%.4f,%.4f,%.4f,%.4f spread=%.3f elapsed=%.1fs\n",
+                    gen, fitness[bestIndex], meanFitness, best.height, best.lines, best.holes, best.bumpiness,
+                    mean.height, mean.lines, mean.holes, mean.bumpiness, optimizer.meanSpread(), secs);
+        std::fflush(stdout);
+    }
+    const AiWeights w = optimizer.current();
+    std::printf("result --weights %.6f,%.6f,%.6f,%.6f\n", w.height, w.lines, w.holes, w.bumpiness);
+    return 0;
+}
+
+// Re-simulates every replay at full speed, spread over all cores, and
+// reports any whose outcome differs from what was recorded
+static int verifyReplays(const SimOptions &opt) {
+    TaskPool pool(opt.threads);
+    vector<ReplayCheck> results(opt.verify.size());
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(opt.verify.size(), [&](size_t i, unsigned) {
+        results[i] = verifyReplay(opt.verify[i].c_str());
+    });
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0;
+    std::uint64_t ticks = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ReplayCheck &r = results[i];
+        ticks += r.ticks;
+        if (r.ok) continue;
+        ++failed;
+        std::printf("FAIL %s: %s (recorded score=%u lines=%u pieces=%u, replayed score=%u lines=%u pieces=%u)\n",
+                    opt.verify[i].c_str(), r.error.c_str(), r.expected.score, r.expected.lines, r.expected.pieces,
+                    r.actual.score, r.actual.lines, r.actual.pieces);
+    }
+    std::printf("verified=%zu failed=%zu ticks=%llu elapsed=%.2fs replays/s=%.0f\n", results.size(), failed,
+                static_cast<unsigned long long>(ticks), secs, results.size() / secs);
+    return failed == 0 ? 0 : 2;
+}
+
+// Random play on every core, reporting board-steps per second
+template <int Width, int Height>
+static int runBatch(const SimOptions &opt) {
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    std::atomic<std::uint64_t> games{0};
+    auto start = std::chrono::steady_clock::now();
+    vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            BasicTetrisBatch<Width, Height> batch(opt.boards, opt.seed, std::uint64_t{t} * opt.boards);
+            vector<Action> actions(opt.boards);
+            vector<BasicRowMask<Width>> observations(opt.boards * BasicTetrisBatch<Width, Height>::OBSERVATION_WORDS);
+            std::uint32_t rng = 0x9E3779B9u ^ (opt.seed + t);
+            for (long s = 0; s < opt.steps; ++s) {
+                for (auto &a : actions) a = randomAction(rng);
+                batch.step(actions.data(), observations.data());
+            }
+            games += batch.finishedGames();
+        });
+    }
+    for (auto &w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double boardSteps = static_cast<double>(opt.boards) * opt.steps * threads;
+    std::printf("threads=%u boards=%zu board=%dx%d steps=%ld\n", threads, opt.boards, Width, Height, opt.steps);
+    std::printf("board-steps/s=%.0f games=%llu games/min=%.0f elapsed=%.2fs\n",
+                boardSteps / secs, static_cast<unsigned long long>(games.load()),
+                games.load() / secs * 60.0, secs);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    SimOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opt.ai) return runAiGames(opt);
+    if (opt.generations > 0) return runOptimizer(opt);
+    if (opt.tournament) return runTournament(opt);
+    if (!opt.verify.empty()) return verifyReplays(opt);
+
+    // The engine takes the board size as template arguments, so each size
+    // the throughput run offers is compiled in
+    const int w = opt.boardWidth, h = opt.boardHeight;
+    if (w == COLS && h == ROWS) return runBatch<COLS, ROWS>(opt);
+    if (w == 20 && h == 40) return runBatch<20, 40>(opt);
+    if (w == 32 && h == 200) return runBatch<32, 200>(opt);
+    if (w == 64 && h == 1000) return runBatch<64, 1000>(opt);
+    std::fprintf(stderr, "unsupported board %dx%d\n", w, h);
+    usage(argv[0]);
+    return 1;
+}
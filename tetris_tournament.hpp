@@ -0,0 +1,211 @@
+// Self-play tournaments for tuning the autopilot's heuristic weights. Every
+// (weights, seed) game is one task on a WorkStealingPool: game lengths vary
+// by orders of magnitude, so idle workers steal queued games from busy ones
+// instead of waiting on a fixed share. Each worker keeps its own
+// single-threaded TetrisAi with no time budget, so a game's outcome depends
+// only on its weights and seed. CrossEntropyOptimizer searches the weight
+// space by playing a tournament per generation.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "tetris_engine.hpp"
+#include "tetris_ai.hpp"
+#include "tetris_replay.hpp"
+#include "thread_pool.hpp"
+
+// Ticks the autopilot lets pass before placing each piece, roughly the time
+// it would spend thinking in the real game
+static constexpr int AI_THINK_TICKS = 6;
+
+struct GameResult {
+    unsigned seed = 0;
+    int score = 0;
+    int lines = 0;
+    int level = 0;
+    int pieces = 0;
+    bool toppedOut = false;
+};
+
+// Plays one game until it tops out or has spawned more than maxPieces
+// pieces. Optionally records it and collects decision times.
+inline GameResult playAiGame(TetrisAi &ai, unsigned seed, int maxPieces, ReplayWriter *replay = nullptr,
+                             std::vector<double> *decisionMs = nullptr) {
+    TetrisEngine engine(seed);
+    while (!engine.isGameOver() && engine.getPiecesSpawned() <= maxPieces) {
+        for (int t = 0; t < AI_THINK_TICKS && !engine.isGameOver(); ++t) engine.tick();
+        if (engine.isGameOver()) break;
+        int upcoming[7];
+        int known = 0;
+        while (known < 7 && (upcoming[known] = engine.peekNext(known)) >= 0) ++known;
+        AiDecision d = ai.choose(engine.getBoard(), engine.getCurrent(), upcoming, known);
+        if (!d.found) break;
+        if (decisionMs) decisionMs->push_back(d.millis);
+        for (Action a : d.actions) {
+            if (replay) replay->record(engine.getTick(), a);
+            engine.apply(a);
+        }
+    }
+    if (replay) replay->finish(engine.getTick(), summarize(engine));
+    GameResult r;
+    r.seed = seed;
+    r.score = engine.getScore();
+    r.lines = engine.getLinesCleared();
+    r.level = engine.getLevel();
+    r.pieces = engine.getPiecesSpawned();
+    r.toppedOut = engine.isGameOver();
+    return r;
+}
+
+// Distribution of outcomes for one set of weights
+struct TournamentStats {
+    AiWeights weights;
+    int games = 0;
+    int toppedOut = 0;
+    double meanScore = 0, meanLines = 0;
+    int minScore = 0, medianScore = 0, maxScore = 0;
+    int minLines = 0, medianLines = 0, maxLines = 0;
+    std::array<int, MAX_LEVEL + 1> levels{}; // games that ended on each level
+};
+
+inline TournamentStats summarizeResults(const AiWeights &weights, const std::vector<GameResult> &results) {
+    TournamentStats s;
+    s.weights = weights;
+    s.games = static_cast<int>(results.size());
+    if (results.empty()) return s;
+    std::vector<int> scores, lines;
+    for (const GameResult &r : results) {
+        scores.push_back(r.score);
+        lines.push_back(r.lines);
+        s.meanScore += r.score;
+        s.meanLines += r.lines;
+        s.toppedOut += r.toppedOut ? 1 : 0;
+        ++s.levels[r.level];
+    }
+    s.meanScore /= s.games;
+    s.meanLines /= s.games;
+    std::sort(scores.begin(), scores.end());
+    std::sort(lines.begin(), lines.end());
+    s.minScore = scores.front();
+    s.medianScore = scores[scores.size() / 2];
+    s.maxScore = scores.back();
+    s.minLines = lines.front();
+    s.medianLines = lines[lines.size() / 2];
+    s.maxLines = lines.back();
+    return s;
+}
+
+class Tournament {
+public:
+    // aiOptions.threads and budgetMs are overridden: every game runs on one
+    // worker with no time limit
+    Tournament(const AiOptions &aiOptions, unsigned threads) : pool(threads) {
+        AiOptions single = aiOptions;
+        single.threads = 1;
+        single.budgetMs = 0;
+        for (unsigned i = 0; i < pool.size(); ++i) ais.push_back(std::make_unique<TetrisAi>(single));
+    }
+
+    unsigned threads() const { return pool.size(); }
+
+    // Plays every candidate on every seed. results[c][s] is candidate c on
+    // seeds[s], whichever worker happened to play it.
+    std::vector<std::vector<GameResult>> play(const std::vector<AiWeights> &candidates,
+                                              const std::vector<unsigned> &seeds, int maxPieces) {
+        std::vector<std::vector<GameResult>> results(candidates.size(), std::vector<GameResult>(seeds.size()));
+        for (std::size_t c = 0; c < candidates.size(); ++c) {
+            for (std::size_t s = 0; s < seeds.size(); ++s) {
+                pool.submit([&, c, s](unsigned worker) {
+                    TetrisAi &ai = *ais[worker];
+                    ai.setWeights(candidates[c]);
+                    results[c][s] = playAiGame(ai, seeds[s], maxPieces);
+                });
+            }
+        }
+        pool.wait();
+        return results;
+    }
+
+private:
+    WorkStealingPool pool;
+    std::vector<std::unique_ptr<TetrisAi>> ais; // one per worker
+};
+
+inline std::array<float, 4> weightVector(const AiWeights &w) {
+    return {w.height, w.lines, w.holes, w.bumpiness};
+}
+
+inline AiWeights weightsFrom(const std::array<float, 4> &v) {
+    AiWeights w;
+    w.height = v[0];
+    w.lines = v[1];
+    w.holes = v[2];
+    w.bumpiness = v[3];
+    return w;
+}
+
+// Cross-entropy method: sample a population from independent normals around
+// the mean, keep the best few and refit mean and spread to them. Moves are
+// chosen by comparing evaluations, so only the direction of the weight
+// vector matters; samples are normalised to unit length.
+class CrossEntropyOptimizer {
+public:
+    CrossEntropyOptimizer(const AiWeights &start, float sigma, unsigned seed) : rng(seed) {
+        mean = normalized(weightVector(start));
+        spread.fill(sigma);
+    }
+
+    std::vector<AiWeights> sample(int population) {
+        std::vector<AiWeights> out;
+        for (int i = 0; i < population; ++i) {
+            std::array<float, 4> v;
+            for (int k = 0; k < 4; ++k) v[k] = std::normal_distribution<float>(mean[k], spread[k])(rng);
+            out.push_back(weightsFrom(normalized(v)));
+        }
+        return out;
+    }
+
+    // Refits to the `elite` fittest candidates. A small noise floor keeps the
+    // search from collapsing onto an early favourite.
+    void update(const std::vector<AiWeights> &population, const std::vector<double> &fitness, int elite) {
+        std::vector<std::size_t> order(population.size());
+        for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return fitness[a] > fitness[b]; });
+        elite = std::max(1, std::min(elite, static_cast<int>(population.size())));
+        std::array<float, 4> m{}, var{};
+        for (int i = 0; i < elite; ++i) {
+            const auto v = weightVector(population[order[i]]);
+            for (int k = 0; k < 4; ++k) m[k] += v[k] / elite;
+        }
+        for (int i = 0; i < elite; ++i) {
+            const auto v = weightVector(population[order[i]]);
+            for (int k = 0; k < 4; ++k) var[k] += (v[k] - m[k]) * (v[k] - m[k]) / elite;
+        }
+        mean = normalized(m);
+        for (int k = 0; k < 4; ++k) spread[k] = std::sqrt(var[k]) + NOISE_FLOOR;
+    }
+
+    AiWeights current() const { return weightsFrom(mean); }
+    float meanSpread() const { return (spread[0] + spread[1] + spread[2] + spread[3]) / 4; }
+
+private:
+    static constexpr float NOISE_FLOOR = 0.01f;
+
+    std::mt19937 rng;
+    std::array<float, 4> mean, spread;
+
+    static std::array<float, 4> normalized(std::array<float, 4> v) {
+        float len = 0;
+        for (float x : v) len += x * x;
+        len = std::sqrt(len);
+        if (len > 0) {
+            for (float &x : v) x /= len;
+        }
+        return v;
+    }
+};
@@ -0,0 +1,228 @@
+// Thread pools. TaskPool runs data-parallel loops over short, similar work
+// items; WorkStealingPool runs independent tasks of very uneven length.
+// Threads are created once and parked between jobs, so a job costs a
+// wake-up rather than thread creation.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskPool {
+public:
+    // threads == 0 uses one thread per core. The calling thread takes part in
+    // every job, so a pool of N runs N - 1 extra threads.
+    explicit TaskPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 1; i < threads; ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &w : workers) w.join();
+    }
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Calls fn(index, worker) for every index in [0, count) and returns once
+    // all calls have finished. worker is in [0, size()) and is stable for the
+    // duration of a call, so it can index per-thread scratch space.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t, unsigned)> &fn) {
+        if (count == 0) return;
+        if (workers.empty() || count == 1) {
+            for (std::size_t i = 0; i < count; ++i) fn(i, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobSize = count;
+            nextIndex.store(0, std::memory_order_relaxed);
+            busy = static_cast<unsigned>(workers.size());
+            ++generation;
+        }
+        wake.notify_all();
+        runJob(fn, count, 0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(std::size_t, unsigned)> *job = nullptr;
+    std::size_t jobSize = 0;
+    std::atomic<std::size_t> nextIndex{0};
+    unsigned busy = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    void runJob(const std::function<void(std::size_t, unsigned)> &fn, std::size_t count, unsigned worker) {
+        for (std::size_t i = nextIndex.fetch_add(1); i < count; i = nextIndex.fetch_add(1)) {
+            fn(i, worker);
+        }
+    }
+
+    void workerLoop(unsigned worker) {
+        unsigned long long seen = 0;
+        while (true) {
+            const std::function<void(std::size_t, unsigned)> *fn;
+            std::size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                fn = job;
+                count = jobSize;
+            }
+            runJob(*fn, count, worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0) done.notify_one();
+            }
+        }
+    }
+};
+
+// Every worker owns a deque of tasks. It takes work from the back of its
+// own deque and, once that is empty, steals from the front of the others,
+// so long tasks never leave the rest of the pool idle. Tasks submitted from
+// inside a task stay on the submitting worker's deque, close to their
+// parent. Each deque has its own lock, so workers contend only when stealing.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(unsigned worker)>;
+
+    // threads == 0 uses one thread per core
+    explicit WorkStealingPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &w : workers) w.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // Queues a task; it is called with the index of the worker running it
+    void submit(Task task) {
+        unsigned target;
+        if (currentPool == this) {
+            target = currentWorker;
+        } else {
+            target = nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+        }
+        unfinished.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(queues[target]->mutex);
+            queues[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            ++queued;
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until every submitted task, and every task those submitted,
+    // has finished. Must not be called from inside a task.
+    void wait() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        idle.wait(lock, [this] { return unfinished.load() == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // one per worker
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wake, idle;
+    std::size_t queued = 0;                     // tasks waiting in deques; guarded by sleepMutex
+    std::atomic<std::size_t> unfinished{0};     // submitted and not yet finished
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+
+    static inline thread_local WorkStealingPool *currentPool = nullptr;
+    static inline thread_local unsigned currentWorker = 0;
+
+    bool take(unsigned worker, Task &out) {
+        {
+            Queue &own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                out = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (unsigned i = 1; i < size(); ++i) {
+            Queue &victim = *queues[(worker + i) % size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                out = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(unsigned worker) {
+        currentPool = this;
+        currentWorker = worker;
+        Task task;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wake.wait(lock, [this] { return stopping || queued > 0; });
+                if (stopping) return;
+            }
+            if (!take(worker, task)) continue; // another worker got there first
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                --queued;
+            }
+            task(worker);
+            task = nullptr;
+            if (unfinished.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                idle.notify_all();
+            }
+        }
+    }
+};
@@ -0,0 +1,138 @@
+// Fixed-timestep scheduling and input latency measurement shared by both
+// games. Simulation runs in whole steps of a fixed length no matter how
+// fast frames are drawn; rendering interpolates using the leftover fraction.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+class FixedTimestep {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // maxStepsPerFrame caps catch-up after a stall so a slow frame cannot
+    // snowball into ever longer simulation bursts
+    explicit FixedTimestep(double stepSeconds, int maxStepsPerFrame = 16)
+        : stepLength(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(stepSeconds))),
+          maxSteps(maxStepsPerFrame), last(Clock::now()), deadline(last + stepLength) {}
+
+    // Returns how many steps have come due since the previous call. Each step
+    // has its own deadline on the steady clock, one step length after the
+    // last, so whole-tick timing never drifts with frame times or rounding.
+    int advance() {
+        last = Clock::now();
+        int steps = 0;
+        while (last >= deadline) {
+            if (++steps == maxSteps) {
+                deadline = last + stepLength; // drop the backlog rather than fast-forward
+                break;
+            }
+            deadline += stepLength;
+        }
+        return steps;
+    }
+
+    // Discards elapsed time, e.g. while paused
+    void reset() {
+        last = Clock::now();
+        deadline = last + stepLength;
+    }
+
+    // How far into the next step real time was at the last advance(), in [0, 1)
+    float alpha() const {
+        return 1.0f - std::chrono::duration<float>(deadline - last).count() / std::chrono::duration<float>(stepLength).count();
+    }
+    double step() const { return std::chrono::duration<double>(stepLength).count(); }
+    // When the next step is due
+    Clock::time_point nextDeadline() const { return deadline; }
+
+private:
+    Clock::duration stepLength;
+    int maxSteps;
+    Clock::time_point last, deadline;
+};
+
+// Rolling statistics over the most recent millisecond samples
+class LatencyWindow {
+public:
+    struct Stats {
+        std::size_t count = 0; // every sample ever added
+        double meanMs = 0, p50Ms = 0, p99Ms = 0, maxMs = 0;
+    };
+
+    void add(double ms) {
+        samples[next] = ms;
+        next = (next + 1) % samples.size();
+        filled = std::min(filled + 1, samples.size());
+        ++total;
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.count = total;
+        if (filled == 0) return s;
+        std::array<double, WINDOW> sorted;
+        std::copy(samples.begin(), samples.begin() + filled, sorted.begin());
+        std::sort(sorted.begin(), sorted.begin() + filled);
+        double sum = 0;
+        for (std::size_t i = 0; i < filled; ++i) sum += sorted[i];
+        s.meanMs = sum / filled;
+        s.p50Ms = sorted[filled / 2];
+        s.p99Ms = sorted[std::min(filled - 1, filled * 99 / 100)];
+        s.maxMs = sorted[filled - 1];
+        return s;
+    }
+
+private:
+    static constexpr std::size_t WINDOW = 512;
+
+    std::array<double, WINDOW> samples{};
+    std::size_t next = 0, filled = 0, total = 0;
+};
+
+// Measures the time from an input event to the first displayed frame that
+// reflects it. Only one input is tracked at a time; events arriving while
+// one is in flight share its (earlier) timestamp.
+class LatencyTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Stats = LatencyWindow::Stats;
+
+    // An input event arrived
+    void inputReceived() {
+        if (waiting) return;
+        received = Clock::now();
+        waiting = true;
+        applied = false;
+    }
+
+    // The simulation has acted on the waiting input
+    void inputApplied() {
+        if (waiting) applied = true;
+    }
+
+    // Call right after a frame has been displayed
+    void framePresented() {
+        if (!waiting || !applied) return;
+        samples.add(std::chrono::duration<double, std::milli>(Clock::now() - received).count());
+        waiting = applied = false;
+    }
+
+    // Statistics over the most recent samples
+    Stats stats() const { return samples.stats(); }
+
+    void report(const char *name) const {
+        const Stats s = stats();
+        if (s.count == 0) return;
+        std::fprintf(stderr, "%s input-to-display latency: inputs=%zu mean=%.1fms p50=%.1fms p99=%.1fms max=%.1fms\n",
+                     name, s.count, s.meanMs, s.p50Ms, s.p99Ms, s.maxMs);
+    }
+
+private:
+    LatencyWindow samples;
+    Clock::time_point received;
+    bool waiting = false, applied = false;
+};
@@ -0,0 +1,130 @@
+// Wire format between tetris_server and its clients. Every message starts
+// with a one-byte type and has a fixed size for that type, so a stream is
+// split into messages without length prefixes. Integers are little-endian.
+//
+// Client to server:
+//   JOIN   u8 type                               ask to be paired for a match
+//   INPUT  u8 type  u16 seq  u8 action           applied on the match's next tick
+// Server to client:
+//   START  u8 type  u32 match  u64 seed  u8 player
+//   STATE  u8 type  u8 board (0 = yours, 1 = opponent's)  u16 last input seq
+//          u32 tick  u8 kind  u8 rotation  i8 x  i8 y  u32 score  u16 lines
+//          u8 pending garbage  u8 flags (bit 0 game over)  ROWS x u16 row masks
+//   END    u8 type  u8 result (0 lost, 1 won, 2 draw)  u32 tick
+// STATE is only sent for a board that changed during a tick.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "tetris_engine.hpp"
+
+namespace versus {
+
+enum MessageType : std::uint8_t {
+    MSG_JOIN = 0x01,
+    MSG_INPUT = 0x02,
+    MSG_START = 0x81,
+    MSG_STATE = 0x82,
+    MSG_END = 0x83,
+};
+
+enum Result : std::uint8_t { RESULT_LOST = 0, RESULT_WON = 1, RESULT_DRAW = 2 };
+
+static constexpr std::size_t JOIN_SIZE = 1;
+static constexpr std::size_t INPUT_SIZE = 4;
+static constexpr std::size_t START_SIZE = 14;
+static constexpr std::size_t STATE_SIZE = 20 + 2 * ROWS;
+static constexpr std::size_t END_SIZE = 6;
+static constexpr std::uint8_t STATE_GAME_OVER = 1;
+
+// Size of a message of the given type, or 0 for an unknown type
+inline std::size_t messageSize(std::uint8_t type) {
+    switch (type) {
+        case MSG_JOIN: return JOIN_SIZE;
+        case MSG_INPUT: return INPUT_SIZE;
+        case MSG_START: return START_SIZE;
+        case MSG_STATE: return STATE_SIZE;
+        case MSG_END: return END_SIZE;
+        default: return 0;
+    }
+}
+
+inline void putLE(std::vector<std::uint8_t> &out, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+inline std::uint64_t getLE(const std::uint8_t *p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+struct BoardState {
+    std::uint8_t board = 0;
+    std::uint16_t lastSeq = 0;
+    std::uint32_t tick = 0;
+    Piece current{};
+    std::uint32_t score = 0;
+    std::uint16_t lines = 0;
+    std::uint8_t pendingGarbage = 0;
+    bool gameOver = false;
+    Board rows{};
+};
+
+inline void writeJoin(std::vector<std::uint8_t> &out) { out.push_back(MSG_JOIN); }
+
+inline void writeInput(std::vector<std::uint8_t> &out, std::uint16_t seq, Action a) {
+    out.push_back(MSG_INPUT);
+    putLE(out, seq, 2);
+    out.push_back(static_cast<std::uint8_t>(a));
+}
+
+inline void writeStart(std::vector<std::uint8_t> &out, std::uint32_t match, std::uint64_t seed, std::uint8_t player) {
+    out.push_back(MSG_START);
+    putLE(out, match, 4);
+    putLE(out, seed, 8);
+    out.push_back(player);
+}
+
+inline void writeState(std::vector<std::uint8_t> &out, const BoardState &s) {
+    out.push_back(MSG_STATE);
+    out.push_back(s.board);
+    putLE(out, s.lastSeq, 2);
+    putLE(out, s.tick, 4);
+    out.push_back(static_cast<std::uint8_t>(s.current.kind));
+    out.push_back(static_cast<std::uint8_t>(s.current.rotation));
+    out.push_back(static_cast<std::uint8_t>(static_cast<std::int8_t>(s.current.x)));
+    out.push_back(static_cast<std::uint8_t>(static_cast<std::int8_t>(s.current.y)));
+    putLE(out, s.score, 4);
+    putLE(out, s.lines, 2);
+    out.push_back(s.pendingGarbage);
+    out.push_back(s.gameOver ? STATE_GAME_OVER : 0);
+    for (RowMask row : s.rows) putLE(out, row, 2);
+}
+
+inline void writeEnd(std::vector<std::uint8_t> &out, Result result, std::uint32_t tick) {
+    out.push_back(MSG_END);
+    out.push_back(result);
+    putLE(out, tick, 4);
+}
+
+// p points at a whole STATE message
+inline BoardState readState(const std::uint8_t *p) {
+    BoardState s;
+    s.board = p[1];
+    s.lastSeq = static_cast<std::uint16_t>(getLE(p + 2, 2));
+    s.tick = static_cast<std::uint32_t>(getLE(p + 4, 4));
+    s.current.kind = p[8];
+    s.current.rotation = p[9];
+    s.current.x = static_cast<std::int8_t>(p[10]);
+    s.current.y = static_cast<std::int8_t>(p[11]);
+    s.score = static_cast<std::uint32_t>(getLE(p + 12, 4));
+    s.lines = static_cast<std::uint16_t>(getLE(p + 16, 2));
+    s.pendingGarbage = p[18];
+    s.gameOver = (p[19] & STATE_GAME_OVER) != 0;
+    for (int r = 0; r < ROWS; ++r) s.rows[r] = static_cast<RowMask>(getLE(p + 20 + 2 * r, 2));
+    return s;
+}
+
+} // namespace versus
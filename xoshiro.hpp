@@ -0,0 +1,85 @@
+// xoshiro256** (Blackman and Vigna): 32 bytes of state, a few cycles per
+// number, and jump() for splitting one seed into 2^128 non-overlapping
+// streams. Output depends only on the seed, so it is identical on every
+// platform and standard library; std::mt19937 is the same, but it has 2.5 KB
+// of state, and the std distributions built on it are not portable.
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+class Xoshiro256ss {
+public:
+    using result_type = std::uint64_t;
+
+    // The four state words come from splitmix64, which turns any seed,
+    // including 0, into a well-mixed nonzero state
+    explicit Xoshiro256ss(std::uint64_t seed = 0) {
+        for (std::uint64_t &word : s) {
+            seed += 0x9E3779B97F4A7C15ull;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound), by Lemire's multiply-and-reject. Used instead of
+    // std::uniform_int_distribution so results match across standard libraries.
+    std::uint32_t below(std::uint32_t bound) {
+        std::uint64_t m = (operator()() >> 32) * bound;
+        if (static_cast<std::uint32_t>(m) < bound) {
+            const std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+            while (static_cast<std::uint32_t>(m) < threshold) m = (operator()() >> 32) * bound;
+        }
+        return static_cast<std::uint32_t>(m >> 32);
+    }
+
+    // Advances by 2^128 calls. Successive jumps from one seed give streams
+    // that never overlap, for one board or thread each.
+    void jump() {
+        static constexpr std::uint64_t JUMP[] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                                 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+        std::uint64_t t[4] = {0, 0, 0, 0};
+        for (std::uint64_t word : JUMP) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (std::uint64_t{1} << b)) {
+                    for (int i = 0; i < 4; ++i) t[i] ^= s[i];
+                }
+                operator()();
+            }
+        }
+        for (int i = 0; i < 4; ++i) s[i] = t[i];
+    }
+
+    // Raw state, for snapshots. An all-zero state is refused: the generator
+    // would only ever return 0 from it.
+    void getState(std::uint64_t out[4]) const {
+        for (int i = 0; i < 4; ++i) out[i] = s[i];
+    }
+    bool setState(const std::uint64_t in[4]) {
+        if ((in[0] | in[1] | in[2] | in[3]) == 0) return false;
+        for (int i = 0; i < 4; ++i) s[i] = in[i];
+        return true;
+    }
+
+private:
+    std::uint64_t s[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};